@@ -0,0 +1,473 @@
+/* MiniRTOS kernel benchmarks, in the spirit of the Rhealstone benchmark.
+ *
+ * Each benchmark is run by the highest priority task, which creates the tasks of the benchmark and
+ * waits until they are done, then prints one line per benchmark:
+ *
+ *     bench,<name>,<samples>,<min>,<avg>,<max>,<unit>
+ *
+ * The unit is CPU cycles on the target (DWT cycle counter) and ns on the POSIX host port. A sample is
+ * the time from a timestamp in one task to a timestamp in the task which runs because of it, so each
+ * number includes the kernel call and the context switch, and the timestamp overhead.
+ *
+ *   task_switch     OS_Yield() between two tasks of same priority
+ *   preemption      a delayed task woken by the tick preempts a busy lower priority task
+ *   sem_wake        OS_Sem_Post() by a task to a higher priority task waiting on the semaphore
+ *   msgq_round_trip OS_MsgQ_Send() a request to a higher priority task, and OS_MsgQ_Wait() the reply
+ *   msgcq_round_trip the same with OS_MsgCQ_Send() and OS_MsgCQ_Wait(), copying a 16-byte message
+ *   int_latency     an interrupt is raised, its ISR posts a semaphore, the waiting task runs
+ *   deadlock_break  a task waits on a mutex owned by a lower priority task, which inherits the
+ *                   priority, releases the mutex, and the waiting task gets it
+ *   mutex_lock      OS_Mutex_Wait() and OS_Mutex_Post() of a free mutex, with no other task
+ *   tick_delayed_<n> SysTick_Handler() on a tick which wakes no task, with n tasks in the delayed list
+ *   tick_always_sched the same tick with 2 tasks delayed, but OS_sched() is called anyway, as the tick
+ *                   did before it skipped OS_sched() on ticks which change nothing
+ *   sched_prio_<n>  sem_wake with the waiting task at priority n - 1, the top of n priorities. The
+ *                   ready bit map finds it with two CLZ, so it costs the same up to 256 priorities.
+ *                   The cases above MAX_TASK_PRIORITY are left out, the host build sets it to 255
+ *   idle_wakes_<periodic|tickless> wakeups of the idle task while the controller delays 100 ticks
+ *                   with nothing else to run, in "wakes". About one per tick with the periodic tick,
+ *                   and one per delay with tickless idle (TICKLESS_IDLE_ENABLE of the board)
+ *
+ * The EDF utilization is not a benchmark of the kernel calls, Tools/edf_sim.py simulates it.
+ *
+ * The benchmarks use 8 events, with the timer task. The target build needs OS_MAX_EVENTS 10 set in the
+ * project, as bsp.c takes one for the UART, and bench_tm4c123.c stops the build with #error without it.
+ *
+ * The tick benchmarks run first, so the delayed list holds only their tasks and not the parked ones.
+ *
+ * The target build uses bench_tm4c123.c and bsp.c in place of Application/main.c. The host build is
+ * "make bench" in posix-mini-rtos.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "os.h"
+#include "os_sched.h"
+#include "qassert.h"
+#include "bench.h"
+
+Q_DEFINE_THIS_FILE
+
+#define BENCH_SAMPLES       1000U           /* samples of each benchmark */
+#define BENCH_TICK_SAMPLES  200U            /* samples of the benchmarks which wait for a tick */
+#define BENCH_PARK_TICKS    0x10000000U     /* a task done with its benchmark delays for ever */
+#define BENCH_IDLE_TICKS    100U            /* the delay of the idle benchmark */
+#define BENCH_IDLE_SAMPLES  10U
+
+#ifndef BENCH_STK_WORDS
+#define BENCH_STK_WORDS     128U            /* the host port needs more, see its Makefile */
+#endif
+
+/* tasks delayed for the tick benchmarks, the host port runs up to 200, see its Makefile */
+#ifndef BENCH_DLY_TASKS
+#define BENCH_DLY_TASKS     20U
+#endif
+#ifndef BENCH_DLY_STK_WORDS
+#define BENCH_DLY_STK_WORDS 64U             /* they only call OS_Delay() */
+#endif
+
+/* priorities, the controller above all the benchmark tasks */
+#define BENCH_PRIO_CTRL     20U
+#define BENCH_PRIO_LO       5U
+#define BENCH_PRIO_HI       6U
+
+typedef struct bench_stat {
+    uint32_t cnt;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} BENCH_STAT;
+
+static BENCH_STAT bench_stat;
+static volatile uint32_t bench_stamp;       /* timestamp taken by the task which causes the switch */
+static volatile uint8_t bench_stop;
+
+static OS_EVENT *bench_done;                /* posted by a benchmark when it is done */
+static OS_EVENT *bench_sem;
+static OS_EVENT *bench_mutex;
+static OS_EVENT *bench_reqQ;
+static OS_EVENT *bench_rspQ;
+static void *bench_reqQSto[4];
+static void *bench_rspQSto[4];
+
+typedef struct bench_msg {                  /* a sensor sample size message for the copy queues */
+    uint32_t seq;
+    uint32_t data[3];
+} BENCH_MSG;
+
+static OS_EVENT *bench_reqCQ;
+static OS_EVENT *bench_rspCQ;
+static BENCH_MSG bench_reqCQSto[4];
+static BENCH_MSG bench_rspCQSto[4];
+
+/* the tasks of a benchmark never end, so each one has its own */
+#define BENCH_TASKS         20U
+static OS_TCB bench_taskTcb[BENCH_TASKS];
+static uint32_t bench_taskStk[BENCH_TASKS][BENCH_STK_WORDS];
+static uint8_t bench_taskCnt;
+
+static OS_TCB bench_dlyTcb[BENCH_DLY_TASKS];
+static uint32_t bench_dlyStk[BENCH_DLY_TASKS][BENCH_DLY_STK_WORDS];
+static uint16_t bench_dlyCnt;
+
+void SysTick_Handler(void);
+
+static void bench_record(uint32_t delta) {
+    if (bench_stat.cnt == 0U) {
+        bench_stat.min = delta;
+        bench_stat.max = delta;
+    }
+    if (delta < bench_stat.min) {
+        bench_stat.min = delta;
+    }
+    if (delta > bench_stat.max) {
+        bench_stat.max = delta;
+    }
+    bench_stat.sum += delta;
+    bench_stat.cnt++;
+}
+
+static void bench_begin(void) {
+    bench_stat.cnt = 0U;
+    bench_stat.sum = 0U;
+    bench_stop = 0U;
+}
+
+static void bench_printUnit(char const *name, char const *unit) {
+    Q_ASSERT(bench_stat.cnt != 0U);
+    printf("bench,%s,%u,%u,%u,%u,%s\n", name, (unsigned)bench_stat.cnt, (unsigned)bench_stat.min,
+           (unsigned)(bench_stat.sum / bench_stat.cnt), (unsigned)bench_stat.max, unit);
+}
+
+static void bench_print(char const *name) {
+    bench_printUnit(name, BENCH_UNIT);
+}
+
+static void bench_park(void) {
+    while (1) {
+        OS_Delay(BENCH_PARK_TICKS);
+    }
+}
+
+/* task_switch ============================================================================ */
+/* both tasks run this. A task returning from OS_Yield() was switched in by the other one, which took
+   the timestamp before it yielded. The task taking the last sample posts bench_done */
+static void bench_switchTask(void) {
+    while (bench_stat.cnt < BENCH_SAMPLES) {
+        bench_stamp = BENCH_now();
+        OS_Yield();
+        if (bench_stat.cnt < BENCH_SAMPLES) {
+            bench_record(BENCH_now() - bench_stamp);
+            if (bench_stat.cnt == BENCH_SAMPLES) {
+                (void)OS_Sem_Post(bench_done);
+            }
+        }
+    }
+    bench_park();
+}
+
+/* preemption ============================================================================= */
+static void bench_preemptLo(void) {
+    while (bench_stop == 0U) {
+        bench_stamp = BENCH_now();   /* the last one before the tick interrupt */
+    }
+    bench_park();
+}
+
+static void bench_preemptHi(void) {
+    uint32_t i;
+
+    for (i = 0U; i < BENCH_TICK_SAMPLES; i++) {
+        OS_Delay(1U);
+        bench_record(BENCH_now() - bench_stamp);
+    }
+    bench_stop = 1U;
+    (void)OS_Sem_Post(bench_done);
+    bench_park();
+}
+
+/* sem_wake =============================================================================== */
+static void bench_semLo(void) {
+    uint32_t i;
+
+    for (i = 0U; i < BENCH_SAMPLES; i++) {
+        bench_stamp = BENCH_now();
+        (void)OS_Sem_Post(bench_sem);
+    }
+    (void)OS_Sem_Post(bench_done);
+    bench_park();
+}
+
+static void bench_semHi(void) {
+    uint32_t i;
+    uint8_t err;
+
+    for (i = 0U; i < BENCH_SAMPLES; i++) {
+        OS_Sem_Wait(bench_sem, NO_TIMEOUT, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        bench_record(BENCH_now() - bench_stamp);
+    }
+    bench_park();
+}
+
+/* msgq_round_trip ======================================================================== */
+/* the server has the higher priority, so each round trip is two context switches */
+static void bench_msgqClient(void) {
+    uint32_t i;
+    uint32_t stamp;
+    uint8_t err;
+    void *msg;
+
+    for (i = 0U; i < BENCH_SAMPLES; i++) {
+        stamp = BENCH_now();
+        Q_ALLEGE(OS_MsgQ_Send(bench_reqQ, &bench_stat) == OS_ERR_NONE);
+        msg = OS_MsgQ_Wait(bench_rspQ, NO_TIMEOUT, &err);
+        Q_ASSERT((err == OS_ERR_NONE) && (msg == &bench_stat));
+        bench_record(BENCH_now() - stamp);
+    }
+    (void)OS_Sem_Post(bench_done);
+    bench_park();
+}
+
+static void bench_msgqServer(void) {
+    uint8_t err;
+    void *msg;
+
+    while (1) {
+        msg = OS_MsgQ_Wait(bench_reqQ, NO_TIMEOUT, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        Q_ALLEGE(OS_MsgQ_Send(bench_rspQ, msg) == OS_ERR_NONE);
+    }
+}
+
+/* msgcq_round_trip ======================================================================= */
+/* as msgq_round_trip, but the messages are copied in and out of the queues */
+static void bench_msgcqClient(void) {
+    uint32_t i;
+    uint32_t stamp;
+    uint8_t err;
+    BENCH_MSG msg;
+
+    msg.data[0] = 0U;
+    msg.data[1] = 0U;
+    msg.data[2] = 0U;
+    for (i = 0U; i < BENCH_SAMPLES; i++) {
+        stamp = BENCH_now();
+        msg.seq = i;
+        Q_ALLEGE(OS_MsgCQ_Send(bench_reqCQ, &msg) == OS_ERR_NONE);
+        OS_MsgCQ_Wait(bench_rspCQ, &msg, NO_TIMEOUT, &err);
+        Q_ASSERT((err == OS_ERR_NONE) && (msg.seq == i));
+        bench_record(BENCH_now() - stamp);
+    }
+    (void)OS_Sem_Post(bench_done);
+    bench_park();
+}
+
+static void bench_msgcqServer(void) {
+    uint8_t err;
+    BENCH_MSG msg;
+
+    while (1) {
+        OS_MsgCQ_Wait(bench_reqCQ, &msg, NO_TIMEOUT, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        Q_ALLEGE(OS_MsgCQ_Send(bench_rspCQ, &msg) == OS_ERR_NONE);
+    }
+}
+
+/* int_latency ============================================================================ */
+static void bench_isr(void) {
+    (void)OS_Sem_Post(bench_sem);
+}
+
+static void bench_intLo(void) {
+    uint32_t i;
+
+    for (i = 0U; i < BENCH_SAMPLES; i++) {
+        bench_stamp = BENCH_now();
+        BENCH_intTrigger();
+    }
+    (void)OS_Sem_Post(bench_done);
+    bench_park();
+}
+
+/* the waiting task is the same as for sem_wake, only the post is from an ISR */
+
+/* deadlock_break ========================================================================= */
+static void bench_mutexLo(void) {
+    uint32_t i;
+    uint8_t err;
+
+    for (i = 0U; i < BENCH_SAMPLES; i++) {
+        OS_Mutex_Wait(bench_mutex, NO_TIMEOUT, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        (void)OS_Sem_Post(bench_sem);   /* the high task runs, and waits on the mutex */
+        Q_ALLEGE(OS_Mutex_Post(bench_mutex) == OS_ERR_NONE);
+    }
+    (void)OS_Sem_Post(bench_done);
+    bench_park();
+}
+
+static void bench_mutexHi(void) {
+    uint32_t i;
+    uint32_t stamp;
+    uint8_t err;
+
+    for (i = 0U; i < BENCH_SAMPLES; i++) {
+        OS_Sem_Wait(bench_sem, NO_TIMEOUT, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        stamp = BENCH_now();
+        OS_Mutex_Wait(bench_mutex, NO_TIMEOUT, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        bench_record(BENCH_now() - stamp);
+        Q_ALLEGE(OS_Mutex_Post(bench_mutex) == OS_ERR_NONE);
+    }
+    bench_park();
+}
+
+/* mutex_lock ============================================================================= */
+/* the uncontended path, run by the controller itself */
+static void bench_mutexLock(void) {
+    uint32_t i;
+    uint32_t stamp;
+    uint8_t err;
+
+    bench_begin();
+    for (i = 0U; i < BENCH_SAMPLES; i++) {
+        stamp = BENCH_now();
+        OS_Mutex_Wait(bench_mutex, NO_TIMEOUT, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        Q_ALLEGE(OS_Mutex_Post(bench_mutex) == OS_ERR_NONE);
+        bench_record(BENCH_now() - stamp);
+    }
+    bench_print("mutex_lock");
+}
+
+/* tick_delayed_<n> ======================================================================= */
+/* the controller calls SysTick_Handler() in a critical section, as the interrupt runs. The delayed tasks
+   wake up only after BENCH_PARK_TICKS, so the tick decrements the first one and nothing else happens.
+   With 'sched' it calls OS_tick() and OS_sched() instead, the tick without the skip */
+static void bench_tick(char const *name, uint16_t nDly, uint8_t sched) {
+    uint32_t i;
+    uint32_t stamp;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    Q_REQUIRE(nDly <= BENCH_DLY_TASKS);
+    for (; bench_dlyCnt < nDly; bench_dlyCnt++) {
+        OS_Task_Create(&bench_dlyTcb[bench_dlyCnt], BENCH_PRIO_HI, &bench_park,
+                       bench_dlyStk[bench_dlyCnt], sizeof(bench_dlyStk[bench_dlyCnt]));
+    }
+    OS_Delay(2U); /* the new tasks run and delay */
+
+    bench_begin();
+    for (i = 0U; i < BENCH_SAMPLES; i++) {
+        OS_ENTER_CRITICAL();
+        stamp = BENCH_now();
+        if (sched == 0U) {
+            SysTick_Handler();
+        }
+        else {
+            (void)OS_tick();
+            OS_sched();
+        }
+        bench_record(BENCH_now() - stamp);
+        OS_EXIT_CRITICAL();
+    }
+    bench_print(name);
+}
+
+/* idle ================================================================================== */
+/* all the benchmark tasks are parked, so the idle task runs while the controller delays. It wakes up
+   for each interrupt, the ticks with the periodic tick, only the timeout with tickless idle */
+static void bench_idle(void) {
+    uint32_t i;
+    uint32_t wakes;
+    char name[32];
+
+    bench_begin();
+    OS_Delay(1U); /* start on a tick */
+    for (i = 0U; i < BENCH_IDLE_SAMPLES; i++) {
+        wakes = BENCH_idleWakes();
+        OS_Delay(BENCH_IDLE_TICKS);
+        bench_record(BENCH_idleWakes() - wakes);
+    }
+    (void)snprintf(name, sizeof(name), "idle_wakes_%s", BENCH_IDLE);
+    bench_printUnit(name, "wakes");
+}
+
+/* controller ============================================================================= */
+static void bench_taskCreate(OS_TCBHandler task, uint8_t prio) {
+    Q_REQUIRE(bench_taskCnt < BENCH_TASKS);
+    OS_Task_Create(&bench_taskTcb[bench_taskCnt], prio, task, bench_taskStk[bench_taskCnt],
+                   sizeof(bench_taskStk[bench_taskCnt]));
+    bench_taskCnt++;
+}
+
+/* runs one benchmark: creates its tasks, the waiting one first, waits until the benchmark is done and
+   prints the result. The tasks run when the controller waits, in order of priority */
+static void bench_run(char const *name, OS_TCBHandler lo, OS_TCBHandler hi, uint8_t hiPrio) {
+    uint8_t err;
+
+    bench_begin();
+    bench_taskCreate(hi, hiPrio);
+    bench_taskCreate(lo, BENCH_PRIO_LO);
+    OS_Sem_Wait(bench_done, NO_TIMEOUT, &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+
+    bench_print(name);
+    OS_Delay(2U); /* the tasks still running finish and park before the next benchmark */
+}
+
+static OS_TCB bench_ctrlTcb;
+static uint32_t bench_ctrlStk[BENCH_STK_WORDS];
+static void bench_ctrl(void) {
+    printf("bench,name,samples,min,avg,max,unit\n");
+    bench_tick("tick_delayed_2",    2U,   0U);
+    bench_tick("tick_always_sched", 2U,   1U);
+    bench_tick("tick_delayed_20",   20U,  0U);
+#if BENCH_DLY_TASKS >= 200
+    bench_tick("tick_delayed_200",  200U, 0U);
+#endif
+    bench_run("task_switch",     &bench_switchTask, &bench_switchTask, BENCH_PRIO_LO);
+    bench_run("preemption",      &bench_preemptLo,  &bench_preemptHi,  BENCH_PRIO_HI);
+    bench_run("sem_wake",        &bench_semLo,      &bench_semHi,      BENCH_PRIO_HI);
+    bench_run("msgq_round_trip", &bench_msgqClient, &bench_msgqServer, BENCH_PRIO_HI);
+    bench_run("msgcq_round_trip", &bench_msgcqClient, &bench_msgcqServer, BENCH_PRIO_HI);
+    bench_run("sched_prio_8",    &bench_semLo,      &bench_semHi,      7U);
+    bench_run("sched_prio_64",   &bench_semLo,      &bench_semHi,      63U);
+#if MAX_TASK_PRIORITY >= 255
+    bench_run("sched_prio_256",  &bench_semLo,      &bench_semHi,      255U);
+#endif
+    bench_run("int_latency",     &bench_intLo,      &bench_semHi,      BENCH_PRIO_HI);
+    bench_run("deadlock_break",  &bench_mutexLo,    &bench_mutexHi,    BENCH_PRIO_HI);
+    bench_mutexLock();
+    bench_idle();
+    BENCH_done();
+    bench_park();
+}
+
+uint32_t stack_idleThread[BENCH_STK_WORDS];
+
+int main() {
+    BENCH_init();
+    OS_Init(stack_idleThread, sizeof(stack_idleThread));
+
+    bench_done  = OS_Sem_Create(0U, "bench_done");
+    bench_sem   = OS_Sem_Create(0U, "bench_sem");
+    bench_mutex = OS_Mutex_Create("bench_mutex");
+    bench_reqQ  = OS_MsgQ_Create(&bench_reqQSto[0], Q_DIM(bench_reqQSto));
+    bench_rspQ  = OS_MsgQ_Create(&bench_rspQSto[0], Q_DIM(bench_rspQSto));
+    bench_reqCQ = OS_MsgCQ_Create(&bench_reqCQSto[0], Q_DIM(bench_reqCQSto), sizeof(BENCH_MSG));
+    bench_rspCQ = OS_MsgCQ_Create(&bench_rspCQSto[0], Q_DIM(bench_rspCQSto), sizeof(BENCH_MSG));
+    Q_ASSERT((bench_done != (OS_EVENT *)0) && (bench_sem != (OS_EVENT *)0)
+             && (bench_mutex != (OS_EVENT *)0) && (bench_reqQ != (OS_EVENT *)0)
+             && (bench_rspQ != (OS_EVENT *)0) && (bench_reqCQ != (OS_EVENT *)0)
+             && (bench_rspCQ != (OS_EVENT *)0));
+    BENCH_intSet(&bench_isr);
+
+    OS_Task_Create(&bench_ctrlTcb, BENCH_PRIO_CTRL, &bench_ctrl, bench_ctrlStk, sizeof(bench_ctrlStk));
+
+    /* transfer control to the RTOS to run the task */
+    OS_Run();
+    Q_ERROR(); /* Should never reach here */
+    return 0;
+}
@@ -0,0 +1,28 @@
+/* Board part of the MiniRTOS benchmarks, see bench.c. Each board file provides these. */
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdint.h>
+
+/* system clock tick [Hz] */
+#define BENCH_TICKS_PER_SEC 1000U
+
+/* board and timestamp setup, called by main() before OS_Init() */
+void BENCH_init(void);
+
+/* free running timestamp, in BENCH_UNIT, wraps around at 32 bits */
+uint32_t BENCH_now(void);
+extern char const BENCH_UNIT[];
+
+/* a kernel aware interrupt the benchmarks raise by software */
+void BENCH_intSet(void (*isr)(void));
+void BENCH_intTrigger(void);
+
+/* wakeups of the idle task so far, and "periodic" or "tickless", how the idle task sleeps */
+uint32_t BENCH_idleWakes(void);
+extern char const BENCH_IDLE[];
+
+/* called when all the benchmarks are done */
+void BENCH_done(void);
+
+#endif /* __BENCH_H__ */
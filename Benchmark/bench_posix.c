@@ -0,0 +1,68 @@
+/* Board part of the MiniRTOS benchmarks for the POSIX host port, see bench.c.
+ *
+ * The timestamp is CLOCK_MONOTONIC and the benchmark interrupt is the SIGUSR1 interrupt of the port.
+ * Build and run it with "make bench" in posix-mini-rtos. The results depend on the host and its load,
+ * they are for comparing kernel changes on the same machine.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "os.h"
+#include "bench.h"
+
+char const BENCH_UNIT[] = "ns";
+
+/* built with TICKLESS_IDLE_ENABLE, the idle task sleeps till the next timeout, see its Makefile */
+#ifdef TICKLESS_IDLE_ENABLE
+char const BENCH_IDLE[] = "tickless";
+#else
+char const BENCH_IDLE[] = "periodic";
+#endif
+
+static volatile uint32_t bench_idleWakes;
+
+void BENCH_init(void) {
+    setvbuf(stdout, (char *)0, _IOLBF, 0); /* one line at a time, also when piped */
+}
+
+uint32_t BENCH_now(void) {
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec);
+}
+
+void BENCH_intSet(void (*isr)(void)) {
+    OS_CPU_IntSet(isr);
+}
+
+void BENCH_intTrigger(void) {
+    OS_CPU_IntTrigger();
+}
+
+uint32_t BENCH_idleWakes(void) {
+    return bench_idleWakes;
+}
+
+void BENCH_done(void) {
+    exit(0);
+}
+
+void OS_OnStartup(void) {
+    OS_CPU_TickStart(BENCH_TICKS_PER_SEC);
+}
+
+void OS_OnIdle(void) {
+    bench_idleWakes++;
+#ifdef TICKLESS_IDLE_ENABLE
+    (void)OS_CPU_IdleTickless(); /* sleep until the next timeout */
+#else
+    OS_CPU_Idle(); /* sleep until the next tick */
+#endif
+}
+
+_Noreturn void Q_onAssert(char const * const module, int const id) {
+    fprintf(stderr, "assertion failed %s:%d\n", module, id);
+    abort();
+}
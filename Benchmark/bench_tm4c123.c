@@ -0,0 +1,63 @@
+/* Board part of the MiniRTOS benchmarks for the EK-TM4C123GXL board, see bench.c.
+ *
+ * The timestamp is the DWT cycle counter. The benchmark interrupt is GPIOE, which is not used by the
+ * board, pended by software. The rest of the board, the tick, printf() on UART0 and Q_onAssert(), is
+ * bsp.c. To build it, replace Application/main.c with Benchmark/bench.c and this file in the Keil
+ * project, add Benchmark to the include paths, and define OS_MAX_EVENTS=10.
+ */
+#include <stdint.h>
+#include "bsp.h"
+#include "bench.h"
+#include "TM4C123GH6PM.h" /* the TM4C MCU Peripheral Access Layer (TI) */
+
+#define BENCH_INT_PRIO  5U   /* kernel aware, same as GPIOF in bsp.c */
+
+/* the 8 events of bench.c and the UART semaphore of bsp.c, with the timer task semaphore. Without
+   them OS_Sem_Create() returns 0 and the run stops at an assertion, so it is checked at build time */
+#if OS_MAX_EVENTS < 10
+#error "the benchmarks need OS_MAX_EVENTS 10, define OS_MAX_EVENTS=10 in the Keil project"
+#endif
+
+char const BENCH_UNIT[] = "cycles";
+
+#ifdef TICKLESS_IDLE_ENABLE
+char const BENCH_IDLE[] = "tickless";
+#else
+char const BENCH_IDLE[] = "periodic";
+#endif
+
+static void (*bench_isr)(void);
+
+void BENCH_init(void) {
+    BSP_init();
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; /* enable the DWT */
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t BENCH_now(void) {
+    return DWT->CYCCNT;
+}
+
+void BENCH_intSet(void (*isr)(void)) {
+    bench_isr = isr;
+    NVIC_SetPriority(GPIOE_IRQn, BENCH_INT_PRIO);
+    NVIC_EnableIRQ(GPIOE_IRQn);
+}
+
+void BENCH_intTrigger(void) {
+    NVIC_SetPendingIRQ(GPIOE_IRQn);
+}
+
+void GPIOPortE_IRQHandler(void) {
+    bench_isr();
+}
+
+uint32_t BENCH_idleWakes(void) {
+    return BSP_idleWakes;
+}
+
+void BENCH_done(void) {
+    BSP_ledGreenOn();
+}
@@ -13,6 +13,10 @@
 
 typedef unsigned int   OS_CPU_SR;   /* Define size of CPU status register (PSR = 32 bits) */
 
+/* EXC_RETURN of a new task, return to Thread mode on PSP with a basic frame (no floating point
+   context). PendSV_Handler saves the EXC_RETURN of each task in its stack frame */
+#define  OS_CPU_EXC_RETURN_TASK 0xFFFFFFFDu
+
 /*********************************************************************************************************
 *                                    FUNCTION PROTOTYPES
 *********************************************************************************************************
@@ -22,6 +26,11 @@ typedef unsigned int   OS_CPU_SR;   /* Define size of CPU status register (PSR =
 OS_CPU_SR OS_CPU_SR_Save(OS_CPU_SR new_basepri);
 void OS_CPU_SR_Restore(OS_CPU_SR cpu_sr);
 
+/* See OS_CPU_C.C */
+extern uint32_t *OS_CPU_ExceptStkBase;
+void OS_CPU_Init(void);
+uint32_t *OS_CPU_TaskStkInit(void (*task)(), uint32_t *ptos, uint32_t *pbos);
+
 /*
 *********************************************************************************************************
 *                                              Cortex-M
@@ -60,4 +69,12 @@ void OS_CPU_SR_Restore(OS_CPU_SR cpu_sr);
 #define SET_PENDSV_INT_PRIO_TO_LOWEST_LEVEL()  *(uint32_t volatile *)0xE000ED20 |= (0xFFU << 16)
 #define TRIGER_PENDSV_INT() *(uint32_t volatile *)0xE000ED04 = (1U << 28)
 
+/* free running timestamp for the CPU usage of the tasks, the DWT cycle counter (DWT->CYCCNT), started
+   by OS_CPU_Init() */
+#define OS_CPU_TS_GET() (*(uint32_t volatile *)0xE0001004)
+
+/* data memory barrier, memory accesses before it are observed before memory accesses after it. It is
+   also a compiler barrier. Used by the lock-free rings which do not disable interrupts */
+#define OS_CPU_DMB() __asm volatile ("dmb" ::: "memory")
+
 #endif /* __OS_CPU_H__ */
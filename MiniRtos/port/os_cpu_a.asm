@@ -13,6 +13,13 @@
 ; Toolchain : ARM C Compiler
 ;********************************************************************************************************
 ; Note(s)   : This port supports the ARM Cortex-M3, Cortex-M4 and Cortex-M7 architectures.
+;
+;             With the FPU enabled, the CPU stacks S0-S15 and FPSCR lazily (FPCCR.ASPEN and LSPEN are
+;             set out of reset), and PendSV_Handler saves S16-S31 only for a task which used the FPU,
+;             as told by bit 4 of EXC_RETURN. A task which never touches the FPU costs no extra cycles.
+;
+;             Tasks run on the process stack (PSP) and exceptions on the main stack (MSP), whose top is
+;             OS_CPU_ExceptStkBase. PendSV_Handler saves and restores the task context on PSP.
 ;********************************************************************************************************
 
 ;********************************************************************************************************
@@ -20,7 +27,6 @@
 ;********************************************************************************************************
 
     EXTERN  OS_CPU_ExceptStkBase
-    EXTERN  OS_KA_BASEPRI_Boundary
 
     EXTERN  OS_Tcb_Curr
     EXTERN  OS_Tcb_Next
@@ -117,41 +123,61 @@ PendSV_Handler
     CPSID         I
     ;/* if (OS_Tcb_Curr != (OS_TCB *)0) { */
     LDR           r1,=OS_Tcb_Curr
-    LDR           r1,[r1,#0x00]    
-    CMP           r1,#0            
-    BEQ           PendSV_restore 
+    LDR           r1,[r1,#0x00]
+    CBZ           r1,PendSV_first
+
+    ;/*     the task context is on the process stack */
+    MRS           r0,psp
+
+    ;/*     if the task used the FPU (EXC_RETURN bit 4 clear), push s16-s31 on the stack */
+    IF {FPU} != "SoftVFP"
+    TST           lr,#0x10
+    IT            EQ
+    VSTMDBEQ      r0!,{s16-s31}
+    ENDIF
 
-    ;/*     push registers r4-r11 on the stack */
-    PUSH          {r4-r11}          
+    ;/*     push registers r4-r11 and EXC_RETURN on the stack */
+    STMDB         r0!,{r4-r11,lr}
 
     ;/*     OS_Tcb_Curr->OS_TcbSp = sp; */
-    LDR           r1,=OS_Tcb_Curr       
-    LDR           r1,[r1,#0x00]     
-    MOV           r0,sp             
-    STR           r0,[r1,#0x00]    
+    STR           r0,[r1,#0x00]
+    B             PendSV_restore
     ;/* } */
 
-PendSV_restore                   
+PendSV_first
+    ;/* first switch from main(), which never resumes: the exception stack starts from its top */
+    LDR           r0,=OS_CPU_ExceptStkBase
+    LDR           r0,[r0,#0x00]
+    MSR           msp,r0
+
+PendSV_restore
     ;/* sp = OS_Tcb_Next->OS_TcbSp; */
-    LDR           r1,=OS_Tcb_Next       
-    LDR           r1,[r1,#0x00]     
-    LDR           r0,[r1,#0x00]     
-    MOV           sp,r0             
+    LDR           r1,=OS_Tcb_Next
+    LDR           r1,[r1,#0x00]
+    LDR           r0,[r1,#0x00]
 
     ;/* OS_tcb_curr = OS_Tcb_Next; */
-    LDR           r1,=OS_Tcb_Next       
-    LDR           r1,[r1,#0x00]    
-    LDR           r2,=OS_Tcb_Curr       
-    STR           r1,[r2,#0x00]     
+    LDR           r2,=OS_Tcb_Curr
+    STR           r1,[r2,#0x00]
+
+    ;/* pop registers r4-r11 and EXC_RETURN of the next task */
+    LDMIA         r0!,{r4-r11,lr}
+
+    ;/* if the next task used the FPU, pop s16-s31 */
+    IF {FPU} != "SoftVFP"
+    TST           lr,#0x10
+    IT            EQ
+    VLDMIAEQ      r0!,{s16-s31}
+    ENDIF
 
-    ;/* pop registers r4-r11 */
-    POP           {r4-r11}         
+    ;/* the CPU pops the rest of the context from the process stack on return */
+    MSR           psp,r0
 
     ;/* __enable_irq(); */
-    CPSIE         I                
+    CPSIE         I
 
     ;/* return to the next thread */
-    BX            lr                
+    BX            lr
 ;;;;;;;;;;;;;;;;;;;;
 
     ALIGN                                                       ; Removes warning[A1581W]: added <no_padbytes> of padding at <address>
@@ -0,0 +1,99 @@
+/*
+*********************************************************************************************************
+*                                             ARMv7-M Port
+*
+* Filename  : os_cpu_c.c
+* For       : ARMv7-M Cortex-M
+* Toolchain : ARM C Compiler
+*
+* Note(s)   : The stack frame built here must match what PendSV_Handler in os_cpu_a.asm restores.
+*********************************************************************************************************
+*/
+
+#include <stdint.h>
+#include "os_cpu.h"
+
+uint32_t *OS_CPU_ExceptStkBase;              /* Top of the stack of exceptions (MSP) */
+
+/*
+*********************************************************************************************************
+*                                        PORT INITIALIZATION
+*
+* Description: This function is called by OS_Init() to set up the exception stack. The tasks run on the
+*              process stack (PSP), each on its own stack, and the exceptions run on the main stack (MSP),
+*              so a task stack does not need the room of the nested interrupt frames.
+*
+*              main() runs on the main stack until OS_Run() switches to the first task, and never
+*              resumes. So PendSV_Handler moves MSP back to the top of the main stack, as in the vector
+*              table, at the first switch, and the whole main stack is the exception stack. Its size is
+*              Stack_Size in the startup file.
+*
+*              It also starts the DWT cycle counter, the timestamp of OS_CPU_TS_GET().
+*
+* Arguments  : none
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+void OS_CPU_Init(void)
+{
+    uint32_t *vtor;
+
+    vtor = (uint32_t *)(*(uint32_t volatile *)0xE000ED08u);  /* SCB->VTOR, entry 0 is the initial MSP */
+    OS_CPU_ExceptStkBase = (uint32_t *)vtor[0];
+
+    *(uint32_t volatile *)0xE000EDFCu |= (1u << 24);          /* CoreDebug->DEMCR, TRCENA */
+    *(uint32_t volatile *)0xE0001000u |= 1u;                  /* DWT->CTRL, CYCCNTENA */
+}
+
+/*
+*********************************************************************************************************
+*                                        INITIALIZE A TASK'S STACK
+*
+* Description: This function builds the stack frame of a new task, as if the task was switched out by
+*              PendSV_Handler. From the top of the stack:
+*
+*              xPSR, PC, LR, R12, R3-R0     exception frame, restored by the CPU on exception return
+*              EXC_RETURN                   restored to LR by PendSV_Handler, bit 4 clear if the task has
+*                                           a floating point context, then S16-S31 are below R4
+*              R11-R4                       restored by PendSV_Handler
+*
+*              A new task has no floating point context, so S16-S31 are not in the frame. The CPU stacks
+*              the floating point context of a task only after it uses the FPU.
+*
+* Arguments  : task      is the task function, the PC of the first run.
+*
+*              ptos      is the top of the stack, aligned to 8 bytes.
+*
+*              pbos      is the bottom of the stack, not used by this port.
+*
+* Returns    : The stack pointer to save in OS_TcbSp.
+*********************************************************************************************************
+*/
+uint32_t *OS_CPU_TaskStkInit(void (*task)(), uint32_t *ptos, uint32_t *pbos)
+{
+    uint32_t *sp;
+
+    sp = ptos;
+    *(--sp) = (1U << 24);                   /* xPSR, Thumb bit */
+    *(--sp) = (uint32_t)task;               /* PC */
+    /* pre-fill the stack space reserved for registers for easy debug
+     * the stack space will acutully pushed by register's context when context swithch happens */
+    *(--sp) = 0x0000000EU;                  /* LR  */
+    *(--sp) = 0x0000000CU;                  /* R12 */
+    *(--sp) = 0x00000003U;                  /* R3  */
+    *(--sp) = 0x00000002U;                  /* R2  */
+    *(--sp) = 0x00000001U;                  /* R1  */
+    *(--sp) = 0x00000000U;                  /* R0  */
+    *(--sp) = OS_CPU_EXC_RETURN_TASK;       /* EXC_RETURN, basic frame */
+    /* additionally, fake registers R4-R11 */
+    *(--sp) = 0x0000000BU;                  /* R11 */
+    *(--sp) = 0x0000000AU;                  /* R10 */
+    *(--sp) = 0x00000009U;                  /* R9  */
+    *(--sp) = 0x00000008U;                  /* R8  */
+    *(--sp) = 0x00000007U;                  /* R7  */
+    *(--sp) = 0x00000006U;                  /* R6  */
+    *(--sp) = 0x00000005U;                  /* R5  */
+    *(--sp) = 0x00000004U;                  /* R4  */
+    return (sp);
+}
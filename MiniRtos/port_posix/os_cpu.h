@@ -0,0 +1,71 @@
+#ifndef  __OS_CPU_H__
+#define  __OS_CPU_H__
+
+/*
+*********************************************************************************************************
+*                                          POSIX (Linux) Port
+*
+* Filename  : os_cpu.h
+* For       : Linux, glibc, 32 or 64-bit host
+* Toolchain : GCC or Clang
+*
+* Note(s)   : Host simulation port. Each task is a ucontext on its own stack, all in one process and
+*             one thread. SysTick is a periodic SIGALRM, SIGUSR1 is one more kernel aware interrupt for
+*             the application, and the critical sections mask both. The kernel sources are used
+*             unchanged.
+*********************************************************************************************************
+*/
+
+typedef unsigned int   OS_CPU_SR;   /* 1 if the tick signal was already masked, for nesting */
+
+/* least stack a task must have below its saved context, in bytes. The tick signal frames and the C
+   library use the task stacks, so the host needs much bigger stacks than the target */
+#define  OS_CPU_STK_MIN         (8u * 1024u)
+
+/* stack of the timer task, in 32-bit words */
+#define  OS_TMR_TASK_STK_SIZE   (16u * 1024u)
+
+/*********************************************************************************************************
+*                                    FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+/* See OS_CPU_C.C */
+extern volatile int OS_CPU_PendSVReq;
+
+OS_CPU_SR OS_CPU_SR_Save(void);
+void OS_CPU_SR_Restore(OS_CPU_SR cpu_sr);
+void OS_CPU_Init(void);
+uint32_t *OS_CPU_TaskStkInit(void (*task)(), uint32_t *ptos, uint32_t *pbos);
+void OS_CPU_TickStart(uint32_t ticksPerSec);
+void OS_CPU_Idle(void);
+uint32_t OS_CPU_IdleTickless(void);
+void OS_CPU_IntSet(void (*isr)(void));
+void OS_CPU_IntTrigger(void);
+uint32_t OS_CPU_TsGet(void);
+
+/*
+*********************************************************************************************************
+*                                      Critical Section Management
+*
+* The tick signal and SIGUSR1 are the interrupts. The critical sections mask them, and nest:
+* OS_CPU_SR_Save() returns if they were masked already, and OS_CPU_SR_Restore() only unmasks them when
+* leaving the outermost critical section. A context switch requested in a critical section is done there, before unmasking,
+* like PendSV runs when BASEPRI is lowered on the Cortex-M.
+*********************************************************************************************************
+*/
+#define  OS_ENTER_CRITICAL()  do { cpu_sr = OS_CPU_SR_Save();} while (0)
+#define  OS_EXIT_CRITICAL()   do { OS_CPU_SR_Restore(cpu_sr);} while (0)
+#define  OS_CONTEXT_SWITCH()  (OS_CPU_PendSVReq = 1)
+
+/* no PendSV priority on the host, the switch is done when the tick signal is unmasked */
+#define SET_PENDSV_INT_PRIO_TO_LOWEST_LEVEL()  ((void)0)
+#define TRIGER_PENDSV_INT() (OS_CPU_PendSVReq = 1)
+
+/* free running timestamp for the CPU usage of the tasks, in ns */
+#define OS_CPU_TS_GET()  OS_CPU_TsGet()
+
+/* data memory barrier, also a compiler barrier */
+#define OS_CPU_DMB() __sync_synchronize()
+
+#endif /* __OS_CPU_H__ */
@@ -0,0 +1,429 @@
+/*
+*********************************************************************************************************
+*                                          POSIX (Linux) Port
+*
+* Filename  : os_cpu_c.c
+* For       : Linux, glibc, 32 or 64-bit host
+* Toolchain : GCC or Clang
+*
+* Note(s)   : The context of a task is a ucontext_t, kept at the top of the task stack, and OS_TcbSp
+*             points to it. OS_CPU_PendSV() switches the contexts with swapcontext(), from a critical
+*             section or from a signal handler, always with the signals masked. A task resumes where
+*             it was switched out, and unmasks the signals as it was going to, by OS_CPU_SR_Restore() or
+*             by returning from the signal handler.
+*********************************************************************************************************
+*/
+
+#include <signal.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <time.h>
+#include <ucontext.h>
+#include "os.h"
+#include "os_sched.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_FILE
+
+typedef struct os_cpu_ctx {            /* SAVED CONTEXT OF A TASK, at the top of its stack */
+    ucontext_t  OS_CtxUc;              /* Registers, signal mask and stack of the task */
+    void        (*OS_CtxTask)();       /* Task function */
+    void        *OS_CtxStkBase;        /* Lowest address of the stack */
+    size_t      OS_CtxStkSize;         /* Stack size below the context, in bytes */
+    uint8_t     OS_CtxStarted;         /* 0 until the task runs the first time */
+} OS_CPU_CTX;
+
+extern OS_TCB * volatile OS_Tcb_Curr; /* pointer to the current thread */
+extern OS_TCB * volatile OS_Tcb_Next; /* pointer to the next thread to run */
+
+void SysTick_Handler(void);
+
+volatile int OS_CPU_PendSVReq;        /* context switch requested, the PendSV pending bit */
+static sigset_t os_cpuIntSigSet;      /* the signals which are interrupts, SIGALRM and SIGUSR1 */
+static void (*os_cpuIsr)(void);       /* SIGUSR1 interrupt service routine of the application */
+static uint32_t os_cpuTickUs;         /* tick period in us */
+static uint32_t os_cpuMaxIdleTicks;   /* longest tickless sleep, one minute */
+
+static void os_cpuPendSV(void);
+static void os_cpuTickHandler(int sig);
+static void os_cpuIntHandler(int sig);
+static void os_cpuTaskStart(void);
+
+/*
+*********************************************************************************************************
+*                                        PORT INITIALIZATION
+*
+* Description: This function is called by OS_Init() to install the tick signal handler. The tick does
+*              not run until OS_CPU_TickStart().
+*
+* Arguments  : none
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+void OS_CPU_Init(void)
+{
+    struct sigaction sa;
+
+    sigemptyset(&os_cpuIntSigSet);
+    sigaddset(&os_cpuIntSigSet, SIGALRM);
+    sigaddset(&os_cpuIntSigSet, SIGUSR1);
+
+    sa.sa_handler = os_cpuTickHandler;
+    sa.sa_flags   = SA_RESTART;         /* the tick must not fail the system calls of the tasks */
+    sa.sa_mask    = os_cpuIntSigSet;    /* interrupts do not nest */
+    Q_ALLEGE(sigaction(SIGALRM, &sa, (struct sigaction *)0) == 0);
+}
+
+/*
+*********************************************************************************************************
+*                                        START THE TICK
+*
+* Description: This function starts a periodic SIGALRM, the SysTick of the host. It is called by
+*              OS_OnStartup() of the application.
+*
+* Arguments  : ticksPerSec   is the tick rate, up to 1000000.
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+void OS_CPU_TickStart(uint32_t ticksPerSec)
+{
+    struct itimerval it;
+
+    Q_REQUIRE((ticksPerSec != 0u) && (ticksPerSec <= 1000000u));
+    os_cpuTickUs       = 1000000u / ticksPerSec;
+    os_cpuMaxIdleTicks = 60u * ticksPerSec;
+    it.it_interval.tv_sec  = 0;
+    it.it_interval.tv_usec = (suseconds_t)os_cpuTickUs;
+    it.it_value            = it.it_interval;
+    Q_ALLEGE(setitimer(ITIMER_REAL, &it, (struct itimerval *)0) == 0);
+}
+
+/*
+*********************************************************************************************************
+*                                        APPLICATION INTERRUPT
+*
+* Description: OS_CPU_IntSet() installs the service routine of SIGUSR1, a kernel aware interrupt like the
+*              tick, which may post to the kernel objects. OS_CPU_IntTrigger() raises it, like setting the
+*              pending bit of an interrupt on the target. It is serviced at once if not in a critical
+*              section, or when leaving the critical section.
+*
+* Arguments  : isr       is the interrupt service routine.
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+void OS_CPU_IntSet(void (*isr)(void))
+{
+    struct sigaction sa;
+
+    os_cpuIsr = isr;
+    sa.sa_handler = os_cpuIntHandler;
+    sa.sa_flags   = SA_RESTART;
+    sa.sa_mask    = os_cpuIntSigSet;
+    Q_ALLEGE(sigaction(SIGUSR1, &sa, (struct sigaction *)0) == 0);
+}
+
+void OS_CPU_IntTrigger(void)
+{
+    (void)raise(SIGUSR1);
+}
+
+/*
+*********************************************************************************************************
+*                                        TIMESTAMP
+*
+* Description: This function returns CLOCK_MONOTONIC in ns, truncated to 32 bits, the OS_CPU_TS_GET() of
+*              the host. It wraps around in about 4 s, the CPU usage windows must be shorter.
+*
+* Arguments  : none
+*
+* Returns    : The timestamp in ns.
+*********************************************************************************************************
+*/
+uint32_t OS_CPU_TsGet(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec));
+}
+
+/*
+*********************************************************************************************************
+*                                        CRITICAL SECTION
+*
+* Description: OS_CPU_SR_Save() masks the interrupt signals and returns 1 if they were masked already.
+*              OS_CPU_SR_Restore() leaves the critical section. When leaving the outermost one, a
+*              requested context switch is done first, then the signals are unmasked.
+*
+* Arguments  : cpu_sr    is the value returned by OS_CPU_SR_Save() when entering the critical section.
+*
+* Returns    : OS_CPU_SR_Save() returns 1 if the signals were masked, 0 if not.
+*********************************************************************************************************
+*/
+OS_CPU_SR OS_CPU_SR_Save(void)
+{
+    sigset_t old;
+
+    sigprocmask(SIG_BLOCK, &os_cpuIntSigSet, &old);
+    return ((OS_CPU_SR)sigismember(&old, SIGALRM));
+}
+
+void OS_CPU_SR_Restore(OS_CPU_SR cpu_sr)
+{
+    if (cpu_sr != 0u) {                 /* still in an outer critical section or in an interrupt */
+        return;
+    }
+    if (OS_CPU_PendSVReq != 0) {
+        os_cpuPendSV();
+    }
+    sigprocmask(SIG_UNBLOCK, &os_cpuIntSigSet, (sigset_t *)0);
+}
+
+/*
+*********************************************************************************************************
+*                                        IDLE
+*
+* Description: This function is called by OS_OnIdle() of the application to sleep until the next tick,
+*              like WFI on the target.
+*
+* Arguments  : none
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+void OS_CPU_Idle(void)
+{
+    pause();
+}
+
+/*
+*********************************************************************************************************
+*                                        TICKLESS IDLE
+*
+* Description: This function is called by OS_OnIdle() of the application instead of OS_CPU_Idle(), to
+*              sleep through the ticks with nothing to do, like the tickless OS_OnIdle() of bsp.c. The
+*              tick timer is reprogrammed to expire at the tick of the next timeout, and the process waits
+*              for SIGALRM or SIGUSR1 with the signals masked, without running the handler, like WFI with
+*              PRIMASK set. After wakeup, the OS ticks are advanced by the ticks slept in one step, the
+*              signal is made pending again to be serviced when the signals are unmasked, and the tick
+*              timer goes back to one SIGALRM per tick, aligned on the tick boundary.
+*
+* Arguments  : none
+*
+* Returns    : The ticks advanced in one step, 0 if it slept until the next tick only.
+*
+* Note(s)    : The few us the tick timer is stopped while being reprogrammed are lost from OS time.
+*********************************************************************************************************
+*/
+uint32_t OS_CPU_IdleTickless(void)
+{
+    struct itimerval it;
+    struct itimerval stop;
+    sigset_t pending;
+    sigset_t unmasked;
+    uint32_t idleTicks;
+    uint32_t ticksLeft;
+    uint64_t usLeft;
+    int sig;
+    OS_CPU_SR cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    idleTicks = OS_tickNextTimeout();
+    if (idleTicks > os_cpuMaxIdleTicks) {     /* also when no task is delayed (NO_TIMEOUT) */
+        idleTicks = os_cpuMaxIdleTicks;
+    }
+    sigpending(&pending);
+    if ((idleTicks < 2u) || sigismember(&pending, SIGALRM) || sigismember(&pending, SIGUSR1)) {
+        sigprocmask(SIG_BLOCK, (sigset_t *)0, &unmasked);
+        sigdelset(&unmasked, SIGALRM);
+        sigdelset(&unmasked, SIGUSR1);
+        sigsuspend(&unmasked);                /* next tick is needed anyway, normal sleep */
+        OS_EXIT_CRITICAL();
+        return (0u);
+    }
+
+    /* sleep the rest of current tick plus (idleTicks - 1) ticks */
+    memset(&stop, 0, sizeof(stop));
+    Q_ALLEGE(setitimer(ITIMER_REAL, &stop, &it) == 0);
+    usLeft = (uint64_t)it.it_value.tv_sec * 1000000u + (uint64_t)it.it_value.tv_usec;
+    sigpending(&pending);
+    if (sigismember(&pending, SIGALRM) || (usLeft == 0u)) {
+        /* tick boundary reached before the timer stopped, let the tick handle it */
+        if (usLeft == 0u) {
+            usLeft = os_cpuTickUs;
+        }
+        idleTicks = 0u;
+    }
+    else {
+        usLeft += (uint64_t)(idleTicks - 1u) * os_cpuTickUs;
+        it.it_interval.tv_sec  = 0;
+        it.it_interval.tv_usec = 0;
+        it.it_value.tv_sec     = (time_t)(usLeft / 1000000u);
+        it.it_value.tv_usec    = (suseconds_t)(usLeft % 1000000u);
+        Q_ALLEGE(setitimer(ITIMER_REAL, &it, (struct itimerval *)0) == 0);
+
+        do {
+            sig = sigwaitinfo(&os_cpuIntSigSet, (siginfo_t *)0);
+        } while (sig < 0);                    /* EINTR, by a signal which is not an interrupt */
+
+        Q_ALLEGE(setitimer(ITIMER_REAL, &stop, &it) == 0);
+        (void)raise(sig);                     /* serviced when the signals are unmasked */
+        sigpending(&pending);
+        if (sigismember(&pending, SIGALRM)) {
+            /* slept till the timeout. The tick handler is pending and handles the last tick */
+            idleTicks -= 1u;
+            usLeft = os_cpuTickUs;
+        }
+        else {
+            /* woken up earlier by SIGUSR1, count whole ticks passed */
+            usLeft = (uint64_t)it.it_value.tv_sec * 1000000u + (uint64_t)it.it_value.tv_usec;
+            ticksLeft = (uint32_t)((usLeft + os_cpuTickUs - 1u) / os_cpuTickUs);
+            Q_ASSERT(ticksLeft != 0u);        /* else the SIGALRM of the expiry is pending */
+            idleTicks -= ticksLeft;
+            usLeft -= (uint64_t)(ticksLeft - 1u) * os_cpuTickUs;   /* us to next tick boundary */
+        }
+    }
+    /* next SIGALRM at the tick boundary, then one per tick */
+    it.it_interval.tv_sec  = 0;
+    it.it_interval.tv_usec = (suseconds_t)os_cpuTickUs;
+    it.it_value.tv_sec     = (time_t)(usLeft / 1000000u);
+    it.it_value.tv_usec    = (suseconds_t)(usLeft % 1000000u);
+    Q_ALLEGE(setitimer(ITIMER_REAL, &it, (struct itimerval *)0) == 0);
+
+    if (idleTicks != 0u) {
+        if (OS_tickAdvance(idleTicks) != 0u) {
+            OS_sched();
+        }
+    }
+    OS_EXIT_CRITICAL();
+    return (idleTicks);
+}
+
+/*
+*********************************************************************************************************
+*                                        INITIALIZE A TASK'S STACK
+*
+* Description: This function reserves the context of a new task at the top of its stack. The context is
+*              made when the task is switched in the first time, because OS_Task_Create() fills the stack
+*              below the returned pointer after this function.
+*
+* Arguments  : task      is the task function.
+*
+*              ptos      is the top of the stack.
+*
+*              pbos      is the bottom of the stack.
+*
+* Returns    : The pointer to the context, saved in OS_TcbSp.
+*********************************************************************************************************
+*/
+uint32_t *OS_CPU_TaskStkInit(void (*task)(), uint32_t *ptos, uint32_t *pbos)
+{
+    OS_CPU_CTX *pCtx;
+
+    pCtx = (OS_CPU_CTX *)(((uintptr_t)ptos - sizeof(OS_CPU_CTX)) & ~(uintptr_t)15u);
+    Q_REQUIRE((uintptr_t)pCtx >= ((uintptr_t)pbos + OS_CPU_STK_MIN));
+    pCtx->OS_CtxTask    = task;
+    pCtx->OS_CtxStkBase = pbos;
+    pCtx->OS_CtxStkSize = (size_t)((uintptr_t)pCtx - (uintptr_t)pbos);
+    pCtx->OS_CtxStarted = 0u;
+    return ((uint32_t *)pCtx);
+}
+
+/*
+*********************************************************************************************************
+*                                        CONTEXT SWITCH
+*
+* Description: This function is the PendSV_Handler of the host. It switches from OS_Tcb_Curr to
+*              OS_Tcb_Next. The first time, OS_Tcb_Curr is 0 and main() is not saved, it never resumes.
+*              It is called with the interrupt signals masked.
+*
+* Arguments  : none
+*
+* Returns    : none, when the switched out task is switched in again
+*********************************************************************************************************
+*/
+static void os_cpuPendSV(void)
+{
+    OS_CPU_CTX *pPrev;
+    OS_CPU_CTX *pNext;
+
+    OS_CPU_PendSVReq = 0;
+    pPrev = (OS_Tcb_Curr != (OS_TCB *)0) ? (OS_CPU_CTX *)OS_Tcb_Curr->OS_TcbSp : (OS_CPU_CTX *)0;
+    pNext = (OS_CPU_CTX *)OS_Tcb_Next->OS_TcbSp;
+    OS_Tcb_Curr = OS_Tcb_Next;
+    if (pPrev == pNext) {               /* switched back before the switch was done */
+        return;
+    }
+    if (pNext->OS_CtxStarted == 0u) {   /* a new task starts with the interrupt signals unmasked */
+        Q_ALLEGE(getcontext(&pNext->OS_CtxUc) == 0);
+        pNext->OS_CtxUc.uc_stack.ss_sp   = pNext->OS_CtxStkBase;
+        pNext->OS_CtxUc.uc_stack.ss_size = pNext->OS_CtxStkSize;
+        pNext->OS_CtxUc.uc_link          = (ucontext_t *)0;
+        sigdelset(&pNext->OS_CtxUc.uc_sigmask, SIGALRM);
+        sigdelset(&pNext->OS_CtxUc.uc_sigmask, SIGUSR1);
+        makecontext(&pNext->OS_CtxUc, os_cpuTaskStart, 0);
+        pNext->OS_CtxStarted = 1u;
+    }
+    if (pPrev == (OS_CPU_CTX *)0) {
+        setcontext(&pNext->OS_CtxUc);
+    }
+    else {
+        swapcontext(&pPrev->OS_CtxUc, &pNext->OS_CtxUc);
+    }
+}
+
+/*
+*********************************************************************************************************
+*                                        TICK SIGNAL HANDLER
+*
+* Description: This function is the SysTick interrupt of the host. The context switch requested by the
+*              tick is done at the end, like PendSV tail-chains SysTick on the target.
+*
+* Arguments  : sig       is SIGALRM.
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+static void os_cpuTickHandler(int sig)
+{
+    (void)sig;
+    SysTick_Handler();
+    if (OS_CPU_PendSVReq != 0) {
+        os_cpuPendSV();
+    }
+}
+
+static void os_cpuIntHandler(int sig)
+{
+    (void)sig;
+    if (os_cpuIsr != (void (*)(void))0) {
+        os_cpuIsr();
+    }
+    if (OS_CPU_PendSVReq != 0) {
+        os_cpuPendSV();
+    }
+}
+
+/*
+*********************************************************************************************************
+*                                        TASK ENTRY
+*
+* Description: This function runs the task function of the current task, the entry of a new context.
+*              A task must not return.
+*
+* Arguments  : none
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+static void os_cpuTaskStart(void)
+{
+    ((OS_CPU_CTX *)OS_Tcb_Curr->OS_TcbSp)->OS_CtxTask();
+    Q_ERROR();
+}
@@ -28,37 +28,169 @@
 #define LOG2(x) (32U - __builtin_clz(x))
 
 #define OS_EVENT_TBL_SIZE     8
-#define HIGHEST_PRIOTITY_USED 8
+#ifndef OS_MAX_EVENTS                         /* a build may need more, see Benchmark/bench.c */
 #define OS_MAX_EVENTS         8
+#endif
 
 #define OS_ERR_OTHER          128
 #define OS_ERR_NONE           0
 #define OS_ERR_EVENT_TYPE     1
 #define OS_ERR_Q_FULL         2
+#define OS_ERR_FLAG_WAIT_TYPE 3
+#define OS_ERR_Q_EMPTY        4
+#define OS_ERR_TIMEOUT        10
 #define OS_ERR_SEM_OVF        100
+#define OS_ERR_NOT_MUTEX_OWNER 101
 
-#define PRIORITY_TO_BIT(index) (1U << (index - 1U))
+/* Priorities are in groups of 32. A priority is a bit in the bit map word of its group, and a group
+   with any priority used is a bit in the group bit map. */
+#define PRIORITY_TO_GROUP(index) ((uint8_t)((index) >> 5))
+#define PRIORITY_TO_BIT(index)   (1U << ((index) & 31U))
 #define OS_MAX_MQ 8
+#define OS_MAX_CQ 4
+
+/* Round robin time slice of a task in ticks, tasks of same priority are rotated when the running
+   one has run for its time slice. OS_Task_SetTimeQuanta() changes it for a task */
+#define OS_TIME_QUANTA_DFLT   10
+
+/* Earliest deadline first priority, a single priority level. The ready tasks of this priority are
+   ordered by OS_TcbDeadline instead of round robin, so the one with the earliest deadline runs. Making a
+   task ready walks the ready EDF tasks, so it is meant for a few periodic tasks. The other priorities
+   are not changed, tasks above it preempt the EDF tasks and tasks below it run when no EDF task is
+   ready. 0 disables it. Tools/edf_sim.py shows the utilization it schedules against fixed priority */
+#ifndef OS_EDF_PRIO                           /* a build may set it, see posix-mini-rtos/Makefile */
+#define OS_EDF_PRIO           0
+#endif
+
+/* deadline a is before deadline b, the tick count wraps around */
+#define OS_EDF_BEFORE(a, b)   ((int32_t)((uint32_t)(a) - (uint32_t)(b)) < 0)
+
+/* CPU usage of each task. The time a task runs is measured at the task switches with the timestamp
+   of the port, OS_CPU_TS_GET(), the cycle counter on Cortex-M. The load is of the last complete window
+   of OS_CPU_USAGE_WINDOW ticks, see OS_Task_CpuQuery(). 0 compiles it out */
+#define OS_CPU_USAGE_EN       0
+#define OS_CPU_USAGE_WINDOW   1000
+
+/* Stack check. OS_Task_Create() fills the unused part of a task stack with OS_STK_FILL, and the most
+   stack a task has used is found by scanning the fill up from the bottom of the stack. The idle task
+   scans OS_STK_SCAN_WORDS words each time it runs, 0 disables the background scan */
+#define OS_STK_FILL           0xDEADBEEFU
+#define OS_STK_SCAN_WORDS     32
+
+/* Trace recorder. Kernel events are recorded as binary records, with the timestamp OS_CPU_TS_GET(), in
+   a ring of OS_TRACE_SIZE records in RAM, which keeps the last records. Nothing is output while
+   recording, OS_Trace_Dump() writes the ring for Tools/os_trace_decode.py. 0 compiles it out */
+#define OS_TRACE_EN           0
+#define OS_TRACE_SIZE         256             /* records, a power of 2 */
+
+/* Trace events, the arguments of each are in OS_TRACE_REC */
+#define OS_TRACE_EV_SWITCH    1               /* arg0 priority of the next task,   arg1 its TCB */
+#define OS_TRACE_EV_BLOCK     2               /* arg0 OS_TcbState,                 arg1 event or ticks */
+#define OS_TRACE_EV_READY     3               /* arg0 priority of the task readied, arg1 its TCB */
+#define OS_TRACE_EV_TIMEOUT   4               /* arg0 priority of the task readied, arg1 its TCB */
+#define OS_TRACE_EV_POST      5               /* arg0 event type,                  arg1 event */
+#define OS_TRACE_EV_ISR_ENTER 6               /* arg0 exception number */
+#define OS_TRACE_EV_ISR_EXIT  7               /* arg0 exception number */
+#define OS_TRACE_EV_USER      8               /* arg0 and arg1 of the application */
+#define OS_TRACE_EV_STR       9               /* arg1 a constant string, copied by OS_Trace_Dump() */
+
+/* Software timers, serviced by the timer task. The timer task uses one event for its semaphore */
+#define OS_MAX_TMRS           8
+#define OS_TMR_TASK_PRIO      MAX_TASK_PRIORITY
+#ifndef OS_TMR_TASK_STK_SIZE                  /* a port may need more, see os_cpu.h */
+#define OS_TMR_TASK_STK_SIZE  128             /* in 32-bit words */
+#endif
+
+#define OS_ERR_TMR_INVALID    20
+#define OS_ERR_TMR_INACTIVE   21
+
+/* OS_Tmr_Create() options */
+#define OS_TMR_OPT_ONE_SHOT   1
+#define OS_TMR_OPT_PERIODIC   2
+
+/* OS_TmrState */
+#define OS_TMR_STATE_UNUSED   0
+#define OS_TMR_STATE_STOPPED  1
+#define OS_TMR_STATE_RUNNING  2
+
+/* Fixed-size block memory pools. Each pool uses one event for the tasks waiting for a free block */
+#define OS_MAX_MEM_POOLS      4
+
+#define OS_ERR_MEM_INVALID    30
+#define OS_ERR_MEM_FULL       31
+#define OS_ERR_MEM_NO_FREE_BLKS 32
 
 struct os_event;
 struct os_tcb;
 
+typedef uint16_t OS_FLAGS;             /* event flags of an event flag group */
+
+/* OS_Flag_Wait() options, wait for all or any of the flags, and consume the flags got */
+#define OS_FLAG_WAIT_ALL      0
+#define OS_FLAG_WAIT_ANY      1
+#define OS_FLAG_CONSUME       0x80
+
+/* OS_Flag_Post() options */
+#define OS_FLAG_CLR           0
+#define OS_FLAG_SET           1
+
 typedef struct os_tcb {
     void             *OS_TcbSp;           /* stack pointer */
-    uint32_t         OS_TcbTimeout;       /* timeout delay down-counter */
+    uint32_t         OS_TcbTimeout;       /* timeout delay, relative to previous task in DelayedTaskList */
     uint8_t          OS_TcbPrio;          /* thread priority */
+    uint8_t          OS_TcbBasePrio;      /* priority given at creation, OS_TcbPrio may be raised by a mutex */
+    struct os_event  *OS_TcbMutexOwned;   /* Mutexes owned, linked by OS_EventMutexNext */
     struct os_event  *OS_TcbEcbPtr;       /* Pointer to event control block */
     uint8_t          OS_TcbState;         /* Task status */
     uint8_t          OS_TcbStatePend;     /* Task PEND status */
     void             *OS_TcbMQMsg;        /* Message received from OSMboxPost() or OSQPost() */
+    OS_FLAGS         OS_TcbFlagsWait;     /* Event flags the task is waiting for */
+    OS_FLAGS         OS_TcbFlagsRdy;      /* Event flags which made the task ready */
+    uint8_t          OS_TcbFlagsOpt;      /* Event flags wait options */
+    uint32_t         OS_TcbTimeQuanta;    /* Round robin time slice in ticks */
+    uint32_t         OS_TcbTimeQuantaCtr; /* Ticks left of the time slice */
+    uint32_t         OS_TcbDeadline;      /* Absolute deadline in ticks, for an OS_EDF_PRIO task */
+#if OS_CPU_USAGE_EN != 0
+    uint32_t         OS_TcbCpuTime;       /* Time run in window OS_TcbCpuWin, in OS_CPU_TS_GET() units */
+    uint32_t         OS_TcbCpuTimePrev;   /* Time run in the window before OS_TcbCpuWin */
+    uint32_t         OS_TcbCpuWin;        /* Window OS_TcbCpuTime is counted in */
+#endif
+    uint32_t         *OS_TcbStkBase;      /* Bottom of the stack, the lowest address */
+    uint32_t         OS_TcbStkSize;       /* Stack size in 32-bit words */
+    uint32_t         OS_TcbStkFree;       /* Least free stack seen by a stack check, in 32-bit words */
+    struct os_tcb    *OS_TcbCreatedNext;  /* next task in the list of all the tasks created */
     char             *OS_TcbName;          /* TCB name */
+    struct os_tcb    *OS_TcbNext;         /* next task in the task list the task is in */
+    struct os_tcb    *OS_TcbPrev;         /* previous task in the task list the task is in */
+    struct os_tcb    *OS_TcbDlyNext;      /* next task in DelayedTaskList */
+    struct os_tcb    *OS_TcbDlyPrev;      /* previous task in DelayedTaskList */
     /* ... other attributes associated with a thread */
 } OS_TCB;
+
+/* Highest task priority, up to 255. The idle task is priority 0. Each task list, including the wait
+   list of every event, has a link list pointer for each priority, so a higher number costs RAM */
+#ifndef MAX_TASK_PRIORITY                     /* a build may set it, see posix-mini-rtos/Makefile */
+#define MAX_TASK_PRIORITY     63
+#endif
+#define MAX_TASKS_IN_LIST     (MAX_TASK_PRIORITY+1)
+#define PRIORITY_GROUPS       ((MAX_TASKS_IN_LIST + 31) / 32)
+
+/* Tasks of same priority are linked by OS_TcbNext/OS_TcbPrev in the TCBs as a circular list. The
+   first task of the list TaskList[prio] is the one to run next for the priority (round robin cursor),
+   and the last task is TaskList[prio]->OS_TcbPrev. */
+typedef struct task_list{
+    OS_TCB     *TaskList[MAX_TASKS_IN_LIST];
+    uint32_t   TaskGroupBitMap;                      /* bit g set if any priority of group g used */
+    uint32_t   TaskRriorityBitMap[PRIORITY_GROUPS];  /* bit p & 31 of word p >> 5 set if priority p used */
+} Task_List;
+
 typedef struct os_event {
     uint8_t    OS_EventType;           /* Type of event control block                   */
-    void       *OS_EventPtr;           /* Pointer to message or queue structure         */
-    uint16_t   OS_EventCnt;            /* Semaphore Count (not used if other EVENT type)*/    
+    void       *OS_EventPtr;           /* Pointer to message or queue structure, or the owner TCB of a Mutex */
+    uint16_t   OS_EventCnt;            /* Semaphore Count, Mutex nesting count, or event flags */    
     char       *OS_EventName;
+    struct os_event *OS_EventMutexNext; /* Next mutex owned by the same task, for a Mutex */
+    Task_List  OS_EventWaitList;       /* Tasks waiting on this event, by priority      */
 } OS_EVENT;
 
 typedef struct os_mq {            /* MESSAGE QUEUE CONTROL BLOCK */
@@ -71,8 +203,47 @@ typedef struct os_mq {            /* MESSAGE QUEUE CONTROL BLOCK */
     uint16_t     OS_MQEntries;    /* Current number of entries in the queue */
 } OS_MQ;
 
+typedef struct os_cq {            /* COPY MESSAGE QUEUE CONTROL BLOCK */
+    struct os_cq *OS_CQPtr;       /* Link to next queue control block in list of free blocks */
+    uint8_t      *OS_CQStart;     /* Ptr to start of queue data, the slots are contiguous */
+    uint8_t      *OS_CQEnd;       /* Ptr to end   of queue data */
+    uint8_t      *OS_CQIn;        /* Ptr to the slot where next message will be copied in   */
+    uint8_t      *OS_CQOut;       /* Ptr to the slot where next message will be copied out  */
+    uint16_t     OS_CQMsgSize;    /* Size of a message (slot) in bytes */
+    uint16_t     OS_CQSize;       /* Size of queue (maximum number of messages) */
+    uint16_t     OS_CQEntries;    /* Current number of messages in the queue */
+} OS_CQ;
+
+/* Lock-free single producer single consumer ring of 32-bit items. The producer only writes
+   OS_SpscHead and the consumer only writes OS_SpscTail, so no critical section is needed. */
+typedef struct os_spsc {
+    uint32_t          *OS_SpscBuf;     /* Ring storage */
+    uint32_t          OS_SpscMask;     /* Number of items - 1, the number of items is a power of 2 */
+    volatile uint32_t OS_SpscHead;     /* Items put, free running, written by the producer only */
+    volatile uint32_t OS_SpscTail;     /* Items got, free running, written by the consumer only */
+    struct os_event   *OS_SpscSem;     /* Signals the consumer when the ring becomes not empty, or 0 */
+} OS_SPSC;
+
 typedef void (*OS_TCBHandler)();
 
+struct os_tmr;
+typedef void (*OS_TMR_CALLBACK)(struct os_tmr *pTmr, void *pArg);
+
+/* Running timers are a delta list like DelayedTaskList, ordered by expiry, and OS_TmrTimeout holds the
+   ticks to expire after the timer before it. */
+typedef struct os_tmr {                /* TIMER CONTROL BLOCK */
+    struct os_tmr    *OS_TmrNext;      /* Next running timer, or next free timer */
+    struct os_tmr    *OS_TmrPrev;      /* Previous running timer */
+    uint32_t         OS_TmrTimeout;    /* Ticks to expire, relative to previous running timer */
+    uint32_t         OS_TmrDly;        /* Ticks to the first expiry after started */
+    uint32_t         OS_TmrPeriod;     /* Ticks between expiries of a periodic timer */
+    OS_TMR_CALLBACK  OS_TmrCallback;   /* Function called by the timer task when expired */
+    void             *OS_TmrCallbackArg;
+    uint8_t          OS_TmrOpt;        /* OS_TMR_OPT_ONE_SHOT or OS_TMR_OPT_PERIODIC */
+    uint8_t          OS_TmrState;
+    char             *OS_TmrName;
+} OS_TMR;
+
 extern OS_MQ *OS_MQcb_FreeList;       /* Pointer to list of free MESSAGE QUEUE control blocks */
 extern OS_MQ OS_MQcb_Tbl[OS_MAX_MQ];  /* Table of MESSAGE QUEUE control blocks */
 
@@ -87,15 +258,141 @@ void OS_Run(void);
 /* blocking delay */
 void OS_Delay(uint32_t ticks);
 
+/* give the rest of the time slice to the next task of same priority */
+void OS_Yield(void);
+
+/* round robin time slice of a task */
+void OS_Task_SetTimeQuanta(OS_TCB *pTcb, uint32_t quanta);
+
+/* stack usage of a task, and all the tasks created, for a report */
+typedef struct os_stk_data {           /* STACK USAGE OF A TASK, from OS_Task_StkChk() */
+    uint32_t         OS_StkSize;       /* Stack size in bytes */
+    uint32_t         OS_StkUsed;       /* Most stack used in bytes, the high-water mark */
+    uint32_t         OS_StkFree;       /* Stack never used in bytes */
+} OS_STK_DATA;
+
+uint8_t OS_Task_StkChk(OS_TCB *pTcb, OS_STK_DATA *pData);
+OS_TCB *OS_Task_GetNext(OS_TCB *pTcb);
+
+/* earliest deadline first, deadline of a task and periodic release of the calling task */
+void OS_Task_SetDeadline(OS_TCB *pTcb, uint32_t deadline);
+void OS_Task_WaitPeriod(uint32_t period);
+
 /* callback to configure and start interrupts */
 void OS_OnStartup(void);
 
+/* current OS tick count */
+uint32_t OS_TimeGet(void);
+
+/* tickless idle support, ticks to the next timeout and advance OS ticks after sleeping */
+uint32_t OS_tickNextTimeout(void);
+uint8_t OS_tickAdvance(uint32_t ticks);
+
 void OS_Task_Create(OS_TCB *me, uint8_t prio, OS_TCBHandler threadHandler,
                    void *stkSto, uint32_t stkSize);
 OS_EVENT *OS_Sem_Create (uint16_t cnt, char *name);
 uint8_t OS_Sem_Post(OS_EVENT *pEvent);
 void OS_Sem_Wait(OS_EVENT *pEvent, uint32_t timeout, uint8_t *pErr);
 
+#if OS_CPU_USAGE_EN != 0
+typedef struct os_task_cpu_data {      /* CPU USAGE OF A TASK, from OS_Task_CpuQuery() */
+    uint32_t         OS_CpuTime;       /* Time run in the last complete window, in OS_CPU_TS_GET() units */
+    uint32_t         OS_CpuWindow;     /* Length of the last complete window, in OS_CPU_TS_GET() units */
+    uint16_t         OS_CpuLoad;       /* OS_CpuTime per mille of OS_CpuWindow */
+} OS_TASK_CPU_DATA;
+
+/* CPU usage of a task, and of all the tasks but the idle task, in the last complete window */
+uint8_t OS_Task_CpuQuery(OS_TCB *pTcb, OS_TASK_CPU_DATA *pData);
+uint16_t OS_CpuLoad(void);
+#endif
+
+/*********************************************************************
+* MUTEX prototype
+**********************************************************************/
+OS_EVENT *OS_Mutex_Create(char *name);
+void OS_Mutex_Wait(OS_EVENT *pEvent, uint32_t timeout, uint8_t *pErr);
+uint8_t OS_Mutex_Post(OS_EVENT *pEvent);
+
+/*********************************************************************
+* EVENT FLAG GROUP prototype
+**********************************************************************/
+OS_EVENT *OS_Flag_Create(OS_FLAGS flags, char *name);
+OS_FLAGS OS_Flag_Wait(OS_EVENT *pEvent, OS_FLAGS flags, uint8_t opt, uint32_t timeout, uint8_t *pErr);
+uint8_t OS_Flag_Post(OS_EVENT *pEvent, OS_FLAGS flags, uint8_t opt);
+OS_FLAGS OS_Flag_Query(OS_EVENT *pEvent);
+
+typedef struct os_mem {                /* MEMORY POOL CONTROL BLOCK */
+    void             *OS_MemAddr;      /* Start of the block buffer, or next free pool control block */
+    void             *OS_MemFreeList;  /* First free block, each free block links to the next one */
+    struct os_event  *OS_MemEvent;     /* Tasks waiting for a free block */
+    uint32_t         OS_MemBlkSize;    /* Size of a block in bytes */
+    uint16_t         OS_MemNBlks;      /* Number of blocks */
+    uint16_t         OS_MemNFree;      /* Number of free blocks */
+    uint16_t         OS_MemNUsedMax;   /* High-water mark, most blocks used at a time */
+    char             *OS_MemName;
+} OS_MEM;
+
+typedef struct os_mem_data {           /* MEMORY POOL STATISTICS, from OS_MemPool_Query() */
+    uint32_t         OS_BlkSize;
+    uint16_t         OS_NBlks;
+    uint16_t         OS_NFree;
+    uint16_t         OS_NUsed;
+    uint16_t         OS_NUsedMax;
+} OS_MEM_DATA;
+
+/*********************************************************************
+* MEMORY POOL prototype
+**********************************************************************/
+OS_MEM *OS_MemPool_Create(void *addr, uint16_t nblks, uint32_t blkSize, char *name, uint8_t *pErr);
+void *OS_MemPool_Get(OS_MEM *pMem, uint8_t *pErr);
+void *OS_MemPool_Pend(OS_MEM *pMem, uint32_t timeout, uint8_t *pErr);
+uint8_t OS_MemPool_Put(OS_MEM *pMem, void *pBlk);
+uint8_t OS_MemPool_Query(OS_MEM *pMem, OS_MEM_DATA *pData);
+
+/*********************************************************************
+* TIMER prototype
+**********************************************************************/
+OS_TMR *OS_Tmr_Create(uint32_t dly, uint32_t period, uint8_t opt,
+                      OS_TMR_CALLBACK callback, void *pArg, char *name, uint8_t *pErr);
+uint8_t OS_Tmr_Start(OS_TMR *pTmr);
+uint8_t OS_Tmr_Stop(OS_TMR *pTmr);
+uint8_t OS_Tmr_Delete(OS_TMR *pTmr);
+
+/*********************************************************************
+* LOCK-FREE SPSC RING prototype
+**********************************************************************/
+uint8_t OS_Spsc_Create(OS_SPSC *pRing, uint32_t *buf, uint32_t size, uint8_t wake);
+uint8_t OS_Spsc_Put(OS_SPSC *pRing, uint32_t item);
+uint8_t OS_Spsc_Get(OS_SPSC *pRing, uint32_t *pItem);
+void OS_Spsc_Pend(OS_SPSC *pRing, uint32_t *pItem, uint32_t timeout, uint8_t *pErr);
+
+/*********************************************************************
+* TRACE RECORDER prototype
+**********************************************************************/
+typedef struct os_trace_rec {          /* TRACE RECORD, 12 bytes on a 32-bit CPU */
+    uint32_t         OS_TraceTs;       /* OS_CPU_TS_GET() */
+    uint8_t          OS_TraceEvent;    /* OS_TRACE_EV_xxx */
+    uint8_t          OS_TracePrio;     /* Priority of the running task, 0xFF before OS_Run() */
+    uint16_t         OS_TraceArg0;
+    uintptr_t        OS_TraceArg1;
+} OS_TRACE_REC;
+
+#if OS_TRACE_EN != 0
+#define OS_TRACE(event_, arg0_, arg1_) \
+    OS_Trace_Rec((uint8_t)(event_), (uint16_t)(arg0_), (uintptr_t)(arg1_))
+#else
+#define OS_TRACE(event_, arg0_, arg1_) ((void)0)
+#endif
+
+/* at the entry and exit of an interrupt handler, exc_ is the exception number (IRQ number + 16) */
+#define OS_TRACE_ISR_ENTER(exc_) OS_TRACE(OS_TRACE_EV_ISR_ENTER, (exc_), 0)
+#define OS_TRACE_ISR_EXIT(exc_)  OS_TRACE(OS_TRACE_EV_ISR_EXIT, (exc_), 0)
+
+void OS_Trace_Rec(uint8_t event, uint16_t arg0, uintptr_t arg1);
+void OS_Trace_Start(void);
+void OS_Trace_Stop(void);
+void OS_Trace_Dump(void (*write)(void const *pData, uint32_t len));
+
 /*********************************************************************
 * MESSAGE QUEUE prototype
 **********************************************************************/
@@ -104,4 +401,11 @@ OS_EVENT *OS_MsgQ_Create (void **start, uint16_t size);
 void *OS_MsgQ_Wait(OS_EVENT *pEvent, uint32_t timeout, uint8_t *pErr);
 uint8_t OS_MsgQ_Send(OS_EVENT *pEvent, void *pMsg);
 
+/*********************************************************************
+* COPY MESSAGE QUEUE prototype, messages are copied in and out by value
+**********************************************************************/
+OS_EVENT *OS_MsgCQ_Create(void *start, uint16_t size, uint16_t msgSize);
+void OS_MsgCQ_Wait(OS_EVENT *pEvent, void *pMsg, uint32_t timeout, uint8_t *pErr);
+uint8_t OS_MsgCQ_Send(OS_EVENT *pEvent, void *pMsg);
+
 #endif /* __OS_H__ */
@@ -0,0 +1,283 @@
+/****************************************************************************
+* Mini Real-time Operating System (MiniRTOS)
+* version 1.0 2025
+*
+* This software is to illustrate the concepts of Real-Time Operating System (RTOS).
+* This MiniRTOS program is designed to use Array and Bit Map to implement Task List
+* to speed up task search time. Therefore, the task priority is limited 0-31. It allows
+* same priority has more than one tasks. The same priority tasks are arranged with link list.
+* For most applications, few tasks need at same priority. Therefore the same priority task
+* link list should be short, and its search time and variant should be acceptable.
+*
+* This program is under the terms of the GNU General Public License as published by
+* the Free Software Foundation. This program does not have ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See GNU General Public License <https://www.gnu.org/licenses/> for more details.
+*
+* Git repo:
+*
+****************************************************************************/
+#include "os_utils_event.h"
+#include "os.h"
+#include "os_utils_list.h"
+#include "os_sched.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_FILE
+
+extern OS_TCB * volatile OS_Tcb_Curr;  /* pointer to the current thread */
+extern OS_EVENT	*OSEventFreeList;      /* Pointer to list of free EVENT control blocks    */
+
+static OS_FLAGS os_flagTest(OS_FLAGS flags, OS_FLAGS flagsWait, uint8_t opt);
+
+/*
+*********************************************************************************************************
+*                   CREATE AN EVENT FLAG GROUP
+*
+* Description: This function creates an event flag group. The flags are kept in OS_EventCnt of the event
+*              control block, so a group has 16 flags.
+*
+* Arguments  : flags   is the initial value of the flags.
+*
+*              name    is the name of the event flag group.
+*
+* Returns    : != (void *)0  is a pointer to the event control block (OS_EVENT) associated with the
+*                            created event flag group
+*              == (void *)0  if no event control blocks were available
+*********************************************************************************************************
+*/
+OS_EVENT *OS_Flag_Create(OS_FLAGS flags, char *name)
+{
+    OS_EVENT  *pEvent;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    pEvent = OSEventFreeList;                      /* Get next free event control block */
+    if (OSEventFreeList != (OS_EVENT *)0) {        /* See if pool of free ECB pool was empty   */
+        OSEventFreeList = (OS_EVENT *)OSEventFreeList->OS_EventPtr;
+    }
+    OS_EXIT_CRITICAL();
+    if (pEvent != (OS_EVENT *)0) {                  /* Get an event control block */
+        pEvent->OS_EventType    = OS_EVENT_TYPE_FLAG;
+        pEvent->OS_EventCnt     = flags;            /* Set initial flags          */
+        pEvent->OS_EventPtr     = (void *)0;        /* Unlink from ECB free list  */
+        pEvent->OS_EventName    = name;
+        OS_EventWaitListInit(pEvent);               /* Initialize to 'nobody waiting' on flags. */
+    }
+    return (pEvent);
+}
+/*
+*********************************************************************************************************
+*                   WAIT ON AN EVENT FLAG GROUP
+*
+* Description: This function waits for all or any of a set of flags in an event flag group to be set.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired
+*                            event flag group.
+*
+*              flags         is the flags to wait for.
+*
+*              opt           specifies how to wait:
+*
+*                            OS_FLAG_WAIT_ALL    Wait for all the flags to be set.
+*                            OS_FLAG_WAIT_ANY    Wait for any of the flags to be set.
+*
+*                            Add OS_FLAG_CONSUME to clear the flags which made the task ready.
+*
+*              timeout       is an optional timeout period (in clock ticks).  If non-zero, your task will
+*                            wait for the flags up to the amount of time specified by this argument.
+*                            If you specify 0, however, your task will wait forever until the flags
+*                            are set.
+*
+*              perr          is a pointer to where an error message will be deposited.  Possible error
+*                            messages are:
+*
+*                            OS_ERR_NONE           The flags are set.
+*                            OS_ERR_TIMEOUT        The flags were not set within the specified 'timeout'.
+*                            OS_ERR_FLAG_WAIT_TYPE If you didn't pass a valid 'opt'.
+*                            OS_ERR_EVENT_TYPE     If you didn't pass a pointer to an event flag group.
+*
+* Returns    : The flags which made the task ready, or 0 if timeout or error.
+*********************************************************************************************************
+*/
+OS_FLAGS OS_Flag_Wait(OS_EVENT  *pEvent,
+                      OS_FLAGS  flags,
+                      uint8_t   opt,
+                      uint32_t  timeout,
+                      uint8_t   *pErr)
+{
+    OS_FLAGS   flagsRdy;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    if (pEvent->OS_EventType != OS_EVENT_TYPE_FLAG) {  /* Validate event block type */
+        *pErr = OS_ERR_EVENT_TYPE;
+        return ((OS_FLAGS)0);
+    }
+    if ((opt & (uint8_t)~OS_FLAG_CONSUME) > OS_FLAG_WAIT_ANY) {
+        *pErr = OS_ERR_FLAG_WAIT_TYPE;
+        return ((OS_FLAGS)0);
+    }
+    Q_REQUIRE(flags != (OS_FLAGS)0);
+    OS_ENTER_CRITICAL();
+    flagsRdy = os_flagTest(pEvent->OS_EventCnt, flags, opt);
+    if (flagsRdy != (OS_FLAGS)0) {                     /* Flags already set                         */
+        if ((opt & OS_FLAG_CONSUME) != 0u) {
+            pEvent->OS_EventCnt &= (OS_FLAGS)~flagsRdy;
+        }
+        OS_EXIT_CRITICAL();
+        *pErr = OS_ERR_NONE;
+        return (flagsRdy);
+    }
+
+    /* Otherwise, must wait until the flags are set */
+    OS_Tcb_Curr->OS_TcbState     |= OS_STAT_FLAG;     /* Flags not set, pend on event flag group     */
+    OS_Tcb_Curr->OS_TcbStatePend  = OS_STAT_PEND_OK;
+    OS_Tcb_Curr->OS_TcbFlagsWait  = flags;
+    OS_Tcb_Curr->OS_TcbFlagsOpt   = opt;
+    OS_Tcb_Curr->OS_TcbFlagsRdy   = (OS_FLAGS)0;
+    OS_Tcb_Curr->OS_TcbTimeout    = timeout;          /* Store pend timeout in TCB                   */
+    OS_Tcb_Curr->OS_TcbEcbPtr     = pEvent;           /* Store ptr to ECB in current TCB             */
+    OS_EventTaskWait(OS_Tcb_Curr);                    /* Suspend task until flags or timeout         */
+    OS_sched();                                       /* Find next highest priority task ready       */
+    OS_EXIT_CRITICAL();
+    if (OS_Tcb_Curr->OS_TcbStatePend == OS_STAT_PEND_TO) { /* Readied by OS_tick(), not by a post      */
+        *pErr = OS_ERR_TIMEOUT;
+        return ((OS_FLAGS)0);
+    }
+    *pErr = OS_ERR_NONE;
+    return (OS_Tcb_Curr->OS_TcbFlagsRdy);            /* Set (and consumed) by OS_Flag_Post()        */
+}
+/*
+*********************************************************************************************************
+*               POST TO AN EVENT FLAG GROUP
+*
+* Description: This function sets or clears flags in an event flag group. When flags are set, all the
+*              tasks waiting on the group are checked in one pass from the highest priority, and every
+*              task whose wait is satisfied is made ready. A task waiting with OS_FLAG_CONSUME clears its
+*              flags before the lower priority tasks are checked. The scheduler is called once after the
+*              pass, so it is one context switch however many tasks are readied. It can be called from
+*              an ISR.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired
+*                            event flag group.
+*
+*              flags         is the flags to set or clear.
+*
+*              opt           OS_FLAG_SET to set the flags, OS_FLAG_CLR to clear the flags.
+*
+* Returns    : OS_ERR_NONE            The call was successful.
+*              OS_ERR_FLAG_WAIT_TYPE  If you didn't pass a valid 'opt'.
+*              OS_ERR_EVENT_TYPE      If you didn't pass a pointer to an event flag group.
+*********************************************************************************************************
+*/
+uint8_t OS_Flag_Post(OS_EVENT *pEvent, OS_FLAGS flags, uint8_t opt)
+{
+    Task_List  *pWaitList;
+    OS_TCB     *pTcb;
+    OS_TCB     *pNext;
+    OS_TCB     *pLast;
+    OS_FLAGS   flagsRdy;
+    uint32_t   groupMap;
+    uint32_t   prioMap;
+    uint8_t    group;
+    uint8_t    prio;
+    uint8_t    readied;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    if (pEvent->OS_EventType != OS_EVENT_TYPE_FLAG) {  /* Validate event block type */
+        return (OS_ERR_EVENT_TYPE);
+    }
+    OS_TRACE(OS_TRACE_EV_POST, pEvent->OS_EventType, pEvent);
+    if (opt == OS_FLAG_CLR) {
+        OS_ENTER_CRITICAL();
+        pEvent->OS_EventCnt &= (OS_FLAGS)~flags;
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_NONE);
+    }
+    if (opt != OS_FLAG_SET) {
+        return (OS_ERR_FLAG_WAIT_TYPE);
+    }
+    OS_ENTER_CRITICAL();
+    pEvent->OS_EventCnt |= flags;
+    pWaitList = &pEvent->OS_EventWaitList;
+    readied   = 0u;
+    groupMap  = pWaitList->TaskGroupBitMap;          /* Snapshot, readied tasks clear the bit maps  */
+    while (groupMap != 0U) {                         /* From the highest priority group             */
+        group   = (uint8_t)(LOG2(groupMap) - 1U);
+        groupMap &= ~PRIORITY_TO_BIT(group);
+        prioMap = pWaitList->TaskRriorityBitMap[group];
+        while (prioMap != 0U) {
+            prio    = (uint8_t)((group << 5) + LOG2(prioMap) - 1U);
+            prioMap &= ~PRIORITY_TO_BIT(prio);
+            pTcb  = pWaitList->TaskList[prio];
+            pLast = pTcb->OS_TcbPrev;                /* Each task of the priority once, in order    */
+            for (;;) {
+                pNext = pTcb->OS_TcbNext;
+                flagsRdy = os_flagTest(pEvent->OS_EventCnt, pTcb->OS_TcbFlagsWait, pTcb->OS_TcbFlagsOpt);
+                if (flagsRdy != (OS_FLAGS)0) {
+                    if ((pTcb->OS_TcbFlagsOpt & OS_FLAG_CONSUME) != 0u) {
+                        pEvent->OS_EventCnt &= (OS_FLAGS)~flagsRdy;
+                    }
+                    pTcb->OS_TcbFlagsRdy = flagsRdy;
+                    OS_EventTaskReadyByTcb(pTcb, OS_STAT_FLAG, OS_STAT_PEND_OK);
+                    readied = 1u;
+                }
+                if (pTcb == pLast) {
+                    break;
+                }
+                pTcb = pNext;
+            }
+        }
+    }
+    if (readied != 0u) {
+        OS_sched();                                  /* Find HPT ready to run                       */
+    }
+    OS_EXIT_CRITICAL();
+    return (OS_ERR_NONE);
+}
+/*
+*********************************************************************************************************
+*               QUERY AN EVENT FLAG GROUP
+*
+* Description: This function returns the current flags of an event flag group.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired
+*                            event flag group.
+*
+* Returns    : The current flags, or 0 if you didn't pass a pointer to an event flag group.
+*********************************************************************************************************
+*/
+OS_FLAGS OS_Flag_Query(OS_EVENT *pEvent)
+{
+    if (pEvent->OS_EventType != OS_EVENT_TYPE_FLAG) {  /* Validate event block type */
+        return ((OS_FLAGS)0);
+    }
+    return ((OS_FLAGS)pEvent->OS_EventCnt);
+}
+/*
+*********************************************************************************************************
+*               TEST FLAGS OF A WAIT
+*
+* Description: This function checks if the flags satisfy a wait.
+*
+* Arguments  : flags         is the current flags of the event flag group.
+*
+*              flagsWait     is the flags waited for.
+*
+*              opt           is the wait options.
+*
+* Returns    : The flags which satisfy the wait, or 0 if the wait is not satisfied.
+*********************************************************************************************************
+*/
+static OS_FLAGS os_flagTest(OS_FLAGS flags, OS_FLAGS flagsWait, uint8_t opt)
+{
+    OS_FLAGS flagsRdy;
+
+    flagsRdy = flags & flagsWait;
+    if ((opt & (uint8_t)~OS_FLAG_CONSUME) == OS_FLAG_WAIT_ALL) {
+        if (flagsRdy != flagsWait) {
+            flagsRdy = (OS_FLAGS)0;
+        }
+    }
+    return (flagsRdy);
+}
@@ -0,0 +1,309 @@
+/****************************************************************************
+* Mini Real-time Operating System (MiniRTOS)
+* version 1.0 2025
+*
+* This software is to illustrate the concepts of Real-Time Operating System (RTOS).
+* This MiniRTOS program is designed to use Array and Bit Map to implement Task List
+* to speed up task search time. Therefore, the task priority is limited 0-31. It allows
+* same priority has more than one tasks. The same priority tasks are arranged with link list.
+* For most applications, few tasks need at same priority. Therefore the same priority task
+* link list should be short, and its search time and variant should be acceptable.
+*
+* This program is under the terms of the GNU General Public License as published by
+* the Free Software Foundation. This program does not have ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See GNU General Public License <https://www.gnu.org/licenses/> for more details.
+*
+* Git repo:
+*
+****************************************************************************/
+#include "os_utils_event.h"
+#include "os_utils_list.h"
+#include "os.h"
+#include "os_sched.h"
+#include "os_mem.h"
+
+extern OS_TCB * volatile OS_Tcb_Curr; /* pointer to the current thread */
+extern OS_EVENT *OSEventFreeList;     /* Pointer to list of free EVENT control blocks */
+
+OS_MEM *OSMemFreeList;                /* Pointer to list of free MEMORY POOL control blocks */
+OS_MEM OSMemTbl[OS_MAX_MEM_POOLS];    /* Table of MEMORY POOL control blocks */
+
+/*
+*********************************************************************************************************
+*               MEMORY POOL MODULE INITIALIZATION
+*
+* Description : This function is called by OS_Init() to initialize the free list of memory pool control
+*               blocks. The application MUST NOT call this function.
+*
+* Arguments   : none
+*
+* Returns     : none
+*
+* Note(s)    : This function is INTERNAL to OS and your application should not call it.
+*********************************************************************************************************
+*/
+void OS_MemPool_Init(void)
+{
+    uint16_t index;
+
+    OS_MemClr((uint8_t *)&OSMemTbl[0], sizeof(OSMemTbl));        /* Clear the memory pool table            */
+    for (index = 0u; index < (OS_MAX_MEM_POOLS - 1u); index++) { /* Init. list of free MEMORY POOL blocks  */
+        OSMemTbl[index].OS_MemAddr = &OSMemTbl[index + 1u];
+        OSMemTbl[index].OS_MemName = "?";
+    }
+    OSMemTbl[index].OS_MemAddr = (void *)0;
+    OSMemTbl[index].OS_MemName = "?";
+    OSMemFreeList = &OSMemTbl[0];
+}
+/*
+*********************************************************************************************************
+*               CREATE A MEMORY POOL
+*
+* Description: This function creates a pool of fixed-size memory blocks from a buffer given by the
+*              application. The free blocks are linked by their first word, so no memory is needed other
+*              than the buffer, and a block is got or put in constant time.
+*
+* Arguments  : addr      is the start of the buffer, it must be aligned to a pointer.
+*
+*              nblks     is the number of blocks, at least 2.
+*
+*              blkSize   is the size of a block in bytes, at least the size of a pointer and a multiple of
+*                        the size of a pointer, so every block is aligned.
+*
+*              name      is the name of the pool.
+*
+*              perr      is a pointer to where an error message will be deposited:
+*
+*                        OS_ERR_NONE           The pool is created.
+*                        OS_ERR_MEM_INVALID    'addr', 'nblks' or 'blkSize' is not valid.
+*                        OS_ERR_OTHER          No free pool control block or event control block.
+*
+* Returns    : != (OS_MEM *)0  is a pointer to the created pool
+*              == (OS_MEM *)0  if the pool is not created
+*********************************************************************************************************
+*/
+OS_MEM *OS_MemPool_Create(void      *addr,
+                          uint16_t  nblks,
+                          uint32_t  blkSize,
+                          char      *name,
+                          uint8_t   *pErr)
+{
+    OS_MEM     *pMem;
+    OS_EVENT   *pEvent;
+    uint8_t    *pBlk;
+    uint16_t   i;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    if ((addr == (void *)0) ||
+        (((uintptr_t)addr & (sizeof(void *) - 1u)) != 0u) ||
+        (nblks < 2u) ||
+        (blkSize < sizeof(void *)) ||
+        ((blkSize & (sizeof(void *) - 1u)) != 0u)) {
+        *pErr = OS_ERR_MEM_INVALID;
+        return ((OS_MEM *)0);
+    }
+    OS_ENTER_CRITICAL();
+    pMem   = OSMemFreeList;                        /* Get a free pool control block   */
+    pEvent = OSEventFreeList;                      /* and an event for waiting tasks  */
+    if ((pMem == (OS_MEM *)0) || (pEvent == (OS_EVENT *)0)) {
+        OS_EXIT_CRITICAL();
+        *pErr = OS_ERR_OTHER;
+        return ((OS_MEM *)0);
+    }
+    OSMemFreeList   = (OS_MEM *)pMem->OS_MemAddr;
+    OSEventFreeList = (OS_EVENT *)OSEventFreeList->OS_EventPtr;
+    OS_EXIT_CRITICAL();
+
+    pEvent->OS_EventType = OS_EVENT_TYPE_MEM;
+    pEvent->OS_EventCnt  = 0u;
+    pEvent->OS_EventPtr  = pMem;
+    pEvent->OS_EventName = name;
+    OS_EventWaitListInit(pEvent);
+
+    pBlk = (uint8_t *)addr;                        /* Link all blocks to the free list */
+    for (i = 0u; i < (nblks - 1u); i++) {
+        *(void **)pBlk = (void *)(pBlk + blkSize);
+        pBlk += blkSize;
+    }
+    *(void **)pBlk = (void *)0;
+
+    pMem->OS_MemAddr     = addr;
+    pMem->OS_MemFreeList = addr;
+    pMem->OS_MemEvent    = pEvent;
+    pMem->OS_MemBlkSize  = blkSize;
+    pMem->OS_MemNBlks    = nblks;
+    pMem->OS_MemNFree    = nblks;
+    pMem->OS_MemNUsedMax = 0u;
+    pMem->OS_MemName     = name;
+    *pErr = OS_ERR_NONE;
+    return (pMem);
+}
+/*
+*********************************************************************************************************
+*               GET A MEMORY BLOCK
+*
+* Description: This function gets a block from a memory pool without waiting. It can be called from an ISR.
+*
+* Arguments  : pMem      is a pointer to the pool.
+*
+*              perr      is a pointer to where an error message will be deposited:
+*
+*                        OS_ERR_NONE             A block is got.
+*                        OS_ERR_MEM_NO_FREE_BLKS No free block in the pool.
+*
+* Returns    : != (void *)0  is a pointer to the block
+*              == (void *)0  if no free block
+*********************************************************************************************************
+*/
+void *OS_MemPool_Get(OS_MEM *pMem, uint8_t *pErr)
+{
+    void       *pBlk;
+    uint16_t   nUsed;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    pBlk = pMem->OS_MemFreeList;
+    if (pBlk == (void *)0) {
+        OS_EXIT_CRITICAL();
+        *pErr = OS_ERR_MEM_NO_FREE_BLKS;
+        return ((void *)0);
+    }
+    pMem->OS_MemFreeList = *(void **)pBlk;         /* Unlink the first free block */
+    pMem->OS_MemNFree--;
+    nUsed = pMem->OS_MemNBlks - pMem->OS_MemNFree;
+    if (nUsed > pMem->OS_MemNUsedMax) {            /* Update the high-water mark  */
+        pMem->OS_MemNUsedMax = nUsed;
+    }
+    OS_EXIT_CRITICAL();
+    *pErr = OS_ERR_NONE;
+    return (pBlk);
+}
+/*
+*********************************************************************************************************
+*               WAIT FOR A MEMORY BLOCK
+*
+* Description: This function gets a block from a memory pool, and waits if no block is free. The block put
+*              back by OS_MemPool_Put() is given to the highest priority task waiting.
+*
+* Arguments  : pMem      is a pointer to the pool.
+*
+*              timeout   is an optional timeout period (in clock ticks).  If non-zero, your task will
+*                        wait for a block up to the amount of time specified by this argument. If you
+*                        specify 0, however, your task will wait forever until a block is free.
+*
+*              perr      is a pointer to where an error message will be deposited:
+*
+*                        OS_ERR_NONE             A block is got.
+*                        OS_ERR_TIMEOUT          No block was free within the specified 'timeout'.
+*
+* Returns    : != (void *)0  is a pointer to the block
+*              == (void *)0  if timeout
+* Note(s)    : Must not be called from an ISR, use OS_MemPool_Get().
+*********************************************************************************************************
+*/
+void *OS_MemPool_Pend(OS_MEM *pMem, uint32_t timeout, uint8_t *pErr)
+{
+    void       *pBlk;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    pBlk = OS_MemPool_Get(pMem, pErr);
+    if (pBlk != (void *)0) {
+        OS_EXIT_CRITICAL();
+        return (pBlk);
+    }
+
+    /* Otherwise, must wait until a block is put back */
+    OS_Tcb_Curr->OS_TcbState     |= OS_STAT_MEM;      /* No free block, pend on the pool             */
+    OS_Tcb_Curr->OS_TcbStatePend  = OS_STAT_PEND_OK;
+    OS_Tcb_Curr->OS_TcbMQMsg      = (void *)0;
+    OS_Tcb_Curr->OS_TcbTimeout    = timeout;          /* Store pend timeout in TCB                   */
+    OS_Tcb_Curr->OS_TcbEcbPtr     = pMem->OS_MemEvent;
+    OS_EventTaskWait(OS_Tcb_Curr);                    /* Suspend task until block or timeout         */
+    OS_sched();                                       /* Find next highest priority task ready       */
+    OS_EXIT_CRITICAL();
+    if (OS_Tcb_Curr->OS_TcbStatePend == OS_STAT_PEND_TO) { /* Readied by OS_tick(), not by a put       */
+        *pErr = OS_ERR_TIMEOUT;
+        return ((void *)0);
+    }
+    *pErr = OS_ERR_NONE;
+    return (OS_Tcb_Curr->OS_TcbMQMsg);               /* Block handed over by OS_MemPool_Put()       */
+}
+/*
+*********************************************************************************************************
+*               PUT A MEMORY BLOCK BACK
+*
+* Description: This function puts a block back to its memory pool. If tasks are waiting for a block, the
+*              block is given to the highest priority one directly. It can be called from an ISR.
+*
+* Arguments  : pMem      is a pointer to the pool.
+*
+*              pBlk      is a pointer to the block, got from the same pool.
+*
+* Returns    : OS_ERR_NONE           The block is put back.
+*              OS_ERR_MEM_INVALID    'pBlk' is not a block of the pool.
+*              OS_ERR_MEM_FULL       All blocks are free already, 'pBlk' is put back twice.
+*********************************************************************************************************
+*/
+uint8_t OS_MemPool_Put(OS_MEM *pMem, void *pBlk)
+{
+    Task_List  *pWaitList;
+    OS_TCB     *pTcb;
+    uint32_t   offset;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    offset = (uint32_t)((uint8_t *)pBlk - (uint8_t *)pMem->OS_MemAddr);
+    if (((uint8_t *)pBlk < (uint8_t *)pMem->OS_MemAddr) ||
+        (offset >= (pMem->OS_MemBlkSize * pMem->OS_MemNBlks)) ||
+        ((offset % pMem->OS_MemBlkSize) != 0u)) {
+        return (OS_ERR_MEM_INVALID);
+    }
+    OS_TRACE(OS_TRACE_EV_POST, OS_EVENT_TYPE_MEM, pMem);
+    OS_ENTER_CRITICAL();
+    if (pMem->OS_MemNFree >= pMem->OS_MemNBlks) {
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_MEM_FULL);
+    }
+    pWaitList = &pMem->OS_MemEvent->OS_EventWaitList;
+    if (pWaitList->TaskGroupBitMap != 0u) {          /* Hand over to the HPT waiting for a block    */
+        pTcb = pWaitList->TaskList[os_utilsGetHighestPriority(pWaitList)];
+        pTcb->OS_TcbMQMsg = pBlk;
+        OS_EventTaskReadyByTcb(pTcb, OS_STAT_MEM, OS_STAT_PEND_OK);
+        OS_sched();
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_NONE);
+    }
+    *(void **)pBlk = pMem->OS_MemFreeList;          /* Link the block to the free list */
+    pMem->OS_MemFreeList = pBlk;
+    pMem->OS_MemNFree++;
+    OS_EXIT_CRITICAL();
+    return (OS_ERR_NONE);
+}
+/*
+*********************************************************************************************************
+*               QUERY A MEMORY POOL
+*
+* Description: This function returns the statistics of a memory pool. OS_NUsedMax is the most blocks used
+*              at a time since the pool is created, it is the size the pool needs for the application.
+*
+* Arguments  : pMem      is a pointer to the pool.
+*
+*              pData     is a pointer to where the statistics is copied.
+*
+* Returns    : OS_ERR_NONE
+*********************************************************************************************************
+*/
+uint8_t OS_MemPool_Query(OS_MEM *pMem, OS_MEM_DATA *pData)
+{
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    pData->OS_BlkSize  = pMem->OS_MemBlkSize;
+    pData->OS_NBlks    = pMem->OS_MemNBlks;
+    pData->OS_NFree    = pMem->OS_MemNFree;
+    pData->OS_NUsed    = pMem->OS_MemNBlks - pMem->OS_MemNFree;
+    pData->OS_NUsedMax = pMem->OS_MemNUsedMax;
+    OS_EXIT_CRITICAL();
+    return (OS_ERR_NONE);
+}
@@ -0,0 +1,7 @@
+#ifndef __OS_MEM_H__
+#define __OS_MEM_H__
+#include "os.h"
+
+void OS_MemPool_Init(void);
+
+#endif /* __OS_MEM_H__ */
@@ -0,0 +1,232 @@
+/****************************************************************************
+* Mini Real-time Operating System (MiniRTOS)
+* version 1.0 2025
+*
+* This software is to illustrate the concepts of Real-Time Operating System (RTOS).
+* This MiniRTOS program is designed to use Array and Bit Map to implement Task List
+* to speed up task search time. Therefore, the task priority is limited 0-31. It allows
+* same priority has more than one tasks. The same priority tasks are arranged with link list.
+* For most applications, few tasks need at same priority. Therefore the same priority task
+* link list should be short, and its search time and variant should be acceptable.
+*
+* This program is under the terms of the GNU General Public License as published by
+* the Free Software Foundation. This program does not have ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See GNU General Public License <https://www.gnu.org/licenses/> for more details.
+*
+* Git repo:
+*
+****************************************************************************/
+
+#include "os_utils_event.h"
+#include "os_utils_list.h"
+#include "os.h"
+#include "os_sched.h"
+#include "os_msg_q.h"
+
+extern OS_TCB * volatile OS_Tcb_Curr; /* pointer to the current thread */
+extern OS_EVENT *OSEventFreeList;     /* Pointer to list of free EVENT control blocks */
+
+OS_CQ *OS_CQcb_FreeList;              /* Pointer to list of free COPY QUEUE control blocks */
+OS_CQ OS_CQcb_Tbl[OS_MAX_CQ];         /* Table of COPY QUEUE control blocks */
+
+/*
+*********************************************************************************************************
+*               COPY QUEUE MODULE INITIALIZATION
+*
+* Description : This function is called by OS to initialize the copy message queue module.
+*               The application MUST NOT call this function.
+*
+* Arguments   :  none
+*
+* Returns     : none
+*
+* Note(s)    : This function is INTERNAL to OS and your application should not call it.
+*********************************************************************************************************
+*/
+void  OS_MsgCQ_Init (void)
+{
+    uint16_t index;
+
+    OS_MemClr((uint8_t *)&OS_CQcb_Tbl[0], sizeof(OS_CQcb_Tbl));  /* Clear the queue table                   */
+    for (index = 0u; index < (OS_MAX_CQ - 1u); index++) {        /* Init. list of free QUEUE control blocks */
+        OS_CQcb_Tbl[index].OS_CQPtr = &OS_CQcb_Tbl[index + 1u];
+    }
+    OS_CQcb_Tbl[index].OS_CQPtr = (OS_CQ *)0;
+    OS_CQcb_FreeList = &OS_CQcb_Tbl[0];
+}
+
+/*
+*********************************************************************************************************
+*              CREATE A COPY MESSAGE QUEUE
+*
+* Description: This function creates a message queue which copies the messages by value. Each slot of the
+*              storage holds a message of 'msgSize' bytes, and the slots are contiguous. A message is
+*              copied in by OS_MsgCQ_Send() and copied out by OS_MsgCQ_Wait(), so the sender does not
+*              need to keep the message after sending it.
+*
+* Arguments  : start         is a pointer to the base address of the storage area, of size * msgSize bytes.
+*
+*              size          is the number of messages (slots) in the storage area.
+*
+*              msgSize       is the size of a message in bytes.
+*
+* Returns    : != (OS_EVENT *)0  is a pointer to the event control clock (OS_EVENT) associated with the
+*                                created queue
+*              == (OS_EVENT *)0  if no event or queue control blocks were available
+*********************************************************************************************************
+*/
+OS_EVENT *OS_MsgCQ_Create(void *start, uint16_t size, uint16_t msgSize)
+{
+    OS_EVENT   *pEvent;
+    OS_CQ      *pCQ;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    pEvent = OSEventFreeList;                /* Get a free event control block and a queue control block */
+    pCQ    = OS_CQcb_FreeList;
+    if ((pEvent == (OS_EVENT *)0) || (pCQ == (OS_CQ *)0)) {
+        OS_EXIT_CRITICAL();
+        return ((OS_EVENT *)0);
+    }
+    OSEventFreeList  = (OS_EVENT *)OSEventFreeList->OS_EventPtr;
+    OS_CQcb_FreeList = OS_CQcb_FreeList->OS_CQPtr;
+    OS_EXIT_CRITICAL();
+
+    pCQ->OS_CQStart   = (uint8_t *)start;    /* Initialize the queue */
+    pCQ->OS_CQEnd     = (uint8_t *)start + ((uint32_t)size * msgSize);
+    pCQ->OS_CQIn      = (uint8_t *)start;
+    pCQ->OS_CQOut     = (uint8_t *)start;
+    pCQ->OS_CQMsgSize = msgSize;
+    pCQ->OS_CQSize    = size;
+    pCQ->OS_CQEntries = 0u;
+
+    pEvent->OS_EventType    = OS_EVENT_TYPE_CQ;
+    pEvent->OS_EventCnt     = 0u;
+    pEvent->OS_EventPtr     = pCQ;
+    pEvent->OS_EventName    = "MsgCQ";
+    OS_EventWaitListInit(pEvent);            /* Initialize the wait list */
+    return (pEvent);
+}
+
+/*
+*********************************************************************************************************
+*              SEND/POST MESSAGE TO A COPY QUEUE
+*
+* Description: This function copies a message to a copy queue. If a task is waiting for a message, the
+*              message is copied to the buffer of the highest priority one directly, not to the queue.
+*              It can be called from an ISR.
+*
+* Arguments  : pEvent    is a pointer to the event control block associated with the desired queue
+*
+*              pMsg      is a pointer to the message to copy, of the message size of the queue.
+*
+* Returns    : OS_ERR_NONE           The call was successful and the message was sent
+*              OS_ERR_Q_FULL         If the queue cannot accept any more messages because it is full.
+*              OS_ERR_EVENT_TYPE     If you didn't pass a pointer to a copy queue.
+*********************************************************************************************************
+*/
+uint8_t OS_MsgCQ_Send(OS_EVENT *pEvent, void *pMsg)
+{
+    OS_CQ      *pCQ;
+    Task_List  *pWaitList;
+    OS_TCB     *pTcb;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    if (pEvent->OS_EventType != OS_EVENT_TYPE_CQ) {  /* Validate event block type */
+        return (OS_ERR_EVENT_TYPE);
+    }
+    OS_TRACE(OS_TRACE_EV_POST, pEvent->OS_EventType, pEvent);
+
+    OS_ENTER_CRITICAL();
+    pCQ = (OS_CQ *)pEvent->OS_EventPtr;             /* Point to queue control block */
+    pWaitList = &pEvent->OS_EventWaitList;
+    if (pWaitList->TaskGroupBitMap != 0u) {         /* A task waiting, so the queue is empty */
+        pTcb = pWaitList->TaskList[os_utilsGetHighestPriority(pWaitList)];
+        OS_MemCopy((uint8_t *)pTcb->OS_TcbMQMsg, (uint8_t *)pMsg, pCQ->OS_CQMsgSize);
+        OS_EventTaskReadyByTcb(pTcb, OS_STAT_CQ, OS_STAT_PEND_OK);
+        OS_sched();
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_NONE);
+    }
+    if (pCQ->OS_CQEntries >= pCQ->OS_CQSize) {      /* Make sure queue is not full  */
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_Q_FULL);
+    }
+    OS_MemCopy(pCQ->OS_CQIn, (uint8_t *)pMsg, pCQ->OS_CQMsgSize); /* Copy message into queue */
+    pCQ->OS_CQIn += pCQ->OS_CQMsgSize;
+    pCQ->OS_CQEntries++;                            /* Update the nbr of entries in the queue */
+    if (pCQ->OS_CQIn == pCQ->OS_CQEnd) {            /* Wrap IN ptr if we are at end of queue  */
+        pCQ->OS_CQIn = pCQ->OS_CQStart;
+    }
+    OS_EXIT_CRITICAL();
+    return (OS_ERR_NONE);
+}
+
+/*
+*********************************************************************************************************
+*              WAIT/PEND ON A COPY QUEUE FOR A MESSAGE
+*
+* Description: This function waits for a message to be sent to a copy queue, and copies it to the buffer
+*              of the caller.
+*
+* Arguments  : pevent   is a pointer to the event control block associated with the desired queue
+*
+*              pMsg     is a pointer to the buffer to copy the message to, of the message size of the queue.
+*
+*              timeout  is an optional timeout period (in clock ticks).  If non-zero, your task will
+*                       wait for a message to arrive at the queue up to the amount of time
+*                       specified by this argument.  If you specify 0, however, your task will wait
+*                       forever at the specified queue or, until a message arrives.
+*
+*              perr     is a pointer to where an error message will be deposited.  Possible error
+*                       messages are:
+*
+*                       OS_ERR_NONE         The call was successful and the message is copied to 'pMsg'.
+*                       OS_ERR_TIMEOUT      A message was not received within the specified 'timeout'.
+*                       OS_ERR_EVENT_TYPE   You didn't pass a pointer to a copy queue
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+void OS_MsgCQ_Wait(OS_EVENT *pEvent,
+                   void     *pMsg,
+                   uint32_t timeout,
+                   uint8_t  *pErr)
+{
+    OS_CQ      *pCQ;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    if (pEvent->OS_EventType != OS_EVENT_TYPE_CQ) { /* Validate event block type */
+        *pErr = OS_ERR_EVENT_TYPE;
+        return;
+    }
+    OS_ENTER_CRITICAL();
+    pCQ = (OS_CQ *)pEvent->OS_EventPtr;           /* Point at queue control block */
+    if (pCQ->OS_CQEntries > 0u) {                 /* See if any messages in the queue */
+        OS_MemCopy((uint8_t *)pMsg, pCQ->OS_CQOut, pCQ->OS_CQMsgSize); /* Copy oldest message out */
+        pCQ->OS_CQOut += pCQ->OS_CQMsgSize;
+        pCQ->OS_CQEntries--;
+        if (pCQ->OS_CQOut == pCQ->OS_CQEnd) {     /* Wrap OUT pointer if we are at the end of the queue */
+            pCQ->OS_CQOut = pCQ->OS_CQStart;
+        }
+        OS_EXIT_CRITICAL();
+        *pErr = OS_ERR_NONE;
+        return;
+    }
+
+    /* Otherwise, must wait until a message is sent, it is copied to pMsg by the sender */
+    OS_Tcb_Curr->OS_TcbState     |= OS_STAT_CQ;
+    OS_Tcb_Curr->OS_TcbStatePend  = OS_STAT_PEND_OK;
+    OS_Tcb_Curr->OS_TcbMQMsg      = pMsg;           /* Where the sender copies the message to */
+    OS_Tcb_Curr->OS_TcbTimeout    = timeout;        /* Store pend timeout in TCB */
+    OS_Tcb_Curr->OS_TcbEcbPtr     = pEvent;
+    OS_EventTaskWait(OS_Tcb_Curr);                  /* Suspend task until event or timeout occurs */
+    OS_sched();                                     /* Schedule next highest priority task ready to run */
+    OS_EXIT_CRITICAL();
+    if (OS_Tcb_Curr->OS_TcbStatePend == OS_STAT_PEND_TO) { /* Readied by OS_tick(), not by a send */
+        *pErr = OS_ERR_TIMEOUT;
+        return;
+    }
+    *pErr = OS_ERR_NONE;
+}
@@ -88,40 +88,28 @@ OS_EVENT *OS_MsgQ_Create (void **start,
     OS_CPU_SR  cpu_sr = 0u;
 
     OS_ENTER_CRITICAL();
-    pEvent = OSEventFreeList;                /* Get next free event control block */
-    if (OSEventFreeList != (OS_EVENT *)0) {  /* See if pool of free ECB pool was empty */
-        OSEventFreeList = (OS_EVENT *)OSEventFreeList->OS_EventPtr;
+    pEvent = OSEventFreeList;                /* Get a free event control block and a queue control block */
+    pMsgQ  = OS_MQcb_FreeList;
+    if ((pEvent == (OS_EVENT *)0) || (pMsgQ == (OS_MQ *)0)) {
+        OS_EXIT_CRITICAL();                  /* Nothing is taken from the free lists on error */
+        return ((OS_EVENT *)0);
     }
+    OSEventFreeList  = (OS_EVENT *)OSEventFreeList->OS_EventPtr;
+    OS_MQcb_FreeList = OS_MQcb_FreeList->OS_MQPtr;
     OS_EXIT_CRITICAL();
-    
-    if (pEvent != (OS_EVENT *)0) {           /* See if we have an event control block */
-        OS_ENTER_CRITICAL();
-        pMsgQ = OS_MQcb_FreeList;              /* Get a free queue control block */
-        if (pMsgQ != (OS_MQ *)0) {              /* Were we able to get a queue control block ? */
-            OS_MQcb_FreeList = OS_MQcb_FreeList->OS_MQPtr; /* Yes, Adjust free list pointer to next free*/
-            OS_EXIT_CRITICAL();
-            pMsgQ->OS_MQStart   =  start;      /*      Initialize the queue  */
-            pMsgQ->OS_MQEnd     =  &start[size];
-            pMsgQ->OS_MQIn      =  start;
-            pMsgQ->OS_MQOut     =  start;
-            pMsgQ->OS_MQSize    =  size;
-            pMsgQ->OS_MQEntries = 0u;
-            
-            pEvent->OS_EventType    = OS_EVENT_TYPE_MQ;
-            pEvent->OS_EventCnt     = 0u;
-            pEvent->OS_EventPtr     = pMsgQ;
-            pEvent->OS_EventName    = "MsgQ";
-            //OS_EventWaitListInit(pEvent); /* Initialize the wait list */
-        }
-        else {
-            /* revert pMsgQ */
-        }               
-    } else { /* No. we do not have free event control block */
-        pEvent->OS_EventPtr = (void *)OSEventFreeList; /* Return event control block on error  */
-        OSEventFreeList    = pEvent; /* Previously,get next free event control block  */
-        OS_EXIT_CRITICAL();
-        pEvent = (OS_EVENT *)0;
-    }
+
+    pMsgQ->OS_MQStart   =  start;            /*      Initialize the queue  */
+    pMsgQ->OS_MQEnd     =  &start[size];
+    pMsgQ->OS_MQIn      =  start;
+    pMsgQ->OS_MQOut     =  start;
+    pMsgQ->OS_MQSize    =  size;
+    pMsgQ->OS_MQEntries = 0u;
+
+    pEvent->OS_EventType    = OS_EVENT_TYPE_MQ;
+    pEvent->OS_EventCnt     = 0u;
+    pEvent->OS_EventPtr     = pMsgQ;
+    pEvent->OS_EventName    = "MsgQ";
+    OS_EventWaitListInit(pEvent); /* Initialize the wait list */
     return (pEvent);
 }
 
@@ -129,7 +117,9 @@ OS_EVENT *OS_MsgQ_Create (void **start,
 *********************************************************************************************************
 *              SEND/POST MESSAGE TO A QUEUE
 *
-* Description: This function sends a message to a queue
+* Description: This function sends a message to a queue. If a task is waiting for a message, the queue
+*              is empty, and the message is given to the highest priority waiting task directly in its
+*              TCB, it is not put in the queue. Otherwise the message is put in the queue.
 *
 * Arguments  : pEvent    is a pointer to the event control block associated with the desired queue
 *
@@ -152,8 +142,19 @@ uint8_t OS_MsgQ_Send(OS_EVENT *pEvent, void *pMsg)
     if (pEvent->OS_EventType != OS_EVENT_TYPE_MQ) {  /* Validate event block type */
         return (OS_ERR_EVENT_TYPE);
     }
+    OS_TRACE(OS_TRACE_EV_POST, pEvent->OS_EventType, pEvent);
 
     OS_ENTER_CRITICAL();
+    /* Ready highest priority task waiting on the event, with the message in its TCB */
+    status = OS_EventTaskReady(pEvent, pMsg, OS_STAT_MQ, OS_STAT_PEND_OK);
+    if (status == OS_TASK_PENDING) {
+        /* To schdule highest priority task ready to run */
+        /* If the sender's priority higher than receiver's, */
+        /* after scehdule, sender still runs */
+        OS_sched();
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_NONE);
+    }
     pMq = (OS_MQ *)pEvent->OS_EventPtr;             /* Point to queue control block */
     if (pMq->OS_MQEntries >= pMq->OS_MQSize) {      /* Make sure queue is not full  */
         OS_EXIT_CRITICAL();
@@ -164,19 +165,6 @@ uint8_t OS_MsgQ_Send(OS_EVENT *pEvent, void *pMsg)
     if (pMq->OS_MQIn == pMq->OS_MQEnd) {            /* Wrap IN ptr if we are at end of queue  */
         pMq->OS_MQIn = pMq->OS_MQStart;
     }
-
-    if (WaitingTaskList.TaskRriorityBitMap != 0u)  /* See if any task pending */
-    {
-        /* There is task pending. If the pending ask is waiting for this message */
-        /* Ready highest priority task waiting on the event */
-        status = OS_EventTaskReady(pEvent, pMsg, OS_STAT_MQ, OS_STAT_PEND_OK);
-        if( status == OS_TASK_PENDING ){
-            /* To schdule highest priority task ready to run */
-            /* If the sender's priority higher than receiver's, */
-            /* after scehdule, sender still runs */
-            OS_sched();
-        }            
-    }
     OS_EXIT_CRITICAL();
     return (OS_ERR_NONE);
 }
@@ -229,26 +217,32 @@ void *OS_MsgQ_Wait(OS_EVENT *pEvent,
         *pErr = OS_ERR_EVENT_TYPE;
         return ((void *)0);
     }
+    OS_ENTER_CRITICAL();
     pMsgQ = (OS_MQ *)pEvent->OS_EventPtr;         /* Point at queue control block */
-    while(1){
-        OS_ENTER_CRITICAL();
-        if (pMsgQ->OS_MQEntries > 0u) {           /* See if any messages in the queue */
-            pMessage = *pMsgQ->OS_MQOut++;        /* Yes, extract oldest message from the queue */
-            pMsgQ->OS_MQEntries--;                /* Update the number of entries in the queue */
-            if (pMsgQ->OS_MQOut == pMsgQ->OS_MQEnd) { /* Wrap OUT pointer if we are at the end of the queue */
-                pMsgQ->OS_MQOut = pMsgQ->OS_MQStart;
-            }
-            OS_EXIT_CRITICAL();
-            *pErr = OS_ERR_NONE;
-            return (pMessage); /* Return message received */
-        }else { /* there is no message in the queue */
-            OS_Tcb_Curr->OS_TcbTimeout = timeout;   /* Store pend timeout in TCB */
-            OS_Tcb_Curr->OS_TcbEcbPtr = pEvent;/* Store ptr to ECB in cutrrent TCB. A task can only wait for one event*/
-            OS_EventTaskWait(OS_Tcb_Curr);  /* Suspend task until event or timeout occurs */    
-            OS_sched(); /* Schedule next highest priority task ready to run */
-            OS_EXIT_CRITICAL();
-            /* timeout or abort should be processed here also */
+    if (pMsgQ->OS_MQEntries > 0u) {               /* See if any messages in the queue */
+        pMessage = *pMsgQ->OS_MQOut++;            /* Yes, extract oldest message from the queue */
+        pMsgQ->OS_MQEntries--;                    /* Update the number of entries in the queue */
+        if (pMsgQ->OS_MQOut == pMsgQ->OS_MQEnd) { /* Wrap OUT pointer if we are at the end of the queue */
+            pMsgQ->OS_MQOut = pMsgQ->OS_MQStart;
         }
-    } /* end of while(1) */
-    return ((void*)0);  /* shoud never come to here */
+        OS_EXIT_CRITICAL();
+        *pErr = OS_ERR_NONE;
+        return (pMessage);                        /* Return message received */
+    }
+
+    /* there is no message in the queue, the sender gives the message in the TCB */
+    OS_Tcb_Curr->OS_TcbState    |= OS_STAT_MQ;    /* Queue empty, pend on the queue */
+    OS_Tcb_Curr->OS_TcbStatePend = OS_STAT_PEND_OK;
+    OS_Tcb_Curr->OS_TcbMQMsg     = (void *)0;
+    OS_Tcb_Curr->OS_TcbTimeout   = timeout;       /* Store pend timeout in TCB */
+    OS_Tcb_Curr->OS_TcbEcbPtr    = pEvent;        /* Store ptr to ECB in cutrrent TCB. A task can only wait for one event*/
+    OS_EventTaskWait(OS_Tcb_Curr);                /* Suspend task until event or timeout occurs */
+    OS_sched();                                   /* Schedule next highest priority task ready to run */
+    OS_EXIT_CRITICAL();
+    if (OS_Tcb_Curr->OS_TcbStatePend == OS_STAT_PEND_TO) { /* Readied by OS_tick(), not by a send */
+        *pErr = OS_ERR_TIMEOUT;
+        return ((void *)0);
+    }
+    *pErr = OS_ERR_NONE;
+    return (OS_Tcb_Curr->OS_TcbMQMsg);            /* Message given by OS_MsgQ_Send() */
 }
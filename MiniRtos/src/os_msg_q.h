@@ -11,4 +11,6 @@ OS_EVENT *OS_MsgQ_Create (void **start,
 uint8_t OS_MsgQ_Send(OS_EVENT *pEvent,
                    void     *pMsg);
 
+void  OS_MsgCQ_Init(void);
+
 #endif /* __OS_MSG_Q_H__ */
\ No newline at end of file
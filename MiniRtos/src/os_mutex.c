@@ -0,0 +1,275 @@
+/****************************************************************************
+* Mini Real-time Operating System (MiniRTOS)
+* version 1.0 2025
+*
+* This software is to illustrate the concepts of Real-Time Operating System (RTOS).
+* This MiniRTOS program is designed to use Array and Bit Map to implement Task List
+* to speed up task search time. Therefore, the task priority is limited 0-31. It allows
+* same priority has more than one tasks. The same priority tasks are arranged with link list.
+* For most applications, few tasks need at same priority. Therefore the same priority task
+* link list should be short, and its search time and variant should be acceptable.
+*
+* This program is under the terms of the GNU General Public License as published by
+* the Free Software Foundation. This program does not have ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See GNU General Public License <https://www.gnu.org/licenses/> for more details.
+*
+* Git repo:
+*
+****************************************************************************/
+#include "os_utils_event.h"
+#include "os.h"
+#include "os_utils_list.h"
+#include "os_sched.h"
+#include "os_mutex.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_FILE
+
+extern OS_TCB * volatile OS_Tcb_Curr;  /* pointer to the current thread */
+extern OS_EVENT	*OSEventFreeList;      /* Pointer to list of free EVENT control blocks    */
+
+static void os_mutexOwnerSet(OS_EVENT *pEvent, OS_TCB *pTcb);
+static void os_mutexOwnerClr(OS_EVENT *pEvent);
+
+/*
+*********************************************************************************************************
+*                   CREATE A MUTEX
+*
+* Description: This function creates a mutual exclusion semaphore. The owner of the mutex inherits the
+*              priority of the highest priority task waiting for the mutex, so a low priority owner can
+*              not be preempted by a middle priority task while a high priority task waits.
+*
+* Arguments  : name    is the name of the mutex
+*
+* Returns    : != (void *)0  is a pointer to the event control block (OS_EVENT) associated with the
+*                            created mutex
+*              == (void *)0  if no event control blocks were available
+*********************************************************************************************************
+*/
+OS_EVENT *OS_Mutex_Create(char *name)
+{
+    OS_EVENT  *pEvent;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    pEvent = OSEventFreeList;                      /* Get next free event control block */
+    if (OSEventFreeList != (OS_EVENT *)0) {        /* See if pool of free ECB pool was empty   */
+        OSEventFreeList = (OS_EVENT *)OSEventFreeList->OS_EventPtr;
+    }
+    OS_EXIT_CRITICAL();
+    if (pEvent != (OS_EVENT *)0) {                  /* Get an event control block */
+        pEvent->OS_EventType    = OS_EVENT_TYPE_MUTEX;
+        pEvent->OS_EventCnt     = 0u;               /* Not locked                 */
+        pEvent->OS_EventPtr     = (void *)0;        /* No owner                   */
+        pEvent->OS_EventMutexNext = (OS_EVENT *)0;
+        pEvent->OS_EventName    = name;
+        OS_EventWaitListInit(pEvent);               /* Initialize to 'nobody waiting' on mutex. */
+    }
+    return (pEvent);
+}
+/*
+*********************************************************************************************************
+*                   WAIT ON A MUTEX
+*
+* Description: This function locks a mutex. If the mutex is owned by other task, the calling task waits,
+*              and the owner is raised to the priority of the calling task if it is lower. If the owner
+*              itself waits on another mutex, the owner of that mutex is raised too, and so on. The owner
+*              can lock the mutex again, it must post the mutex as many times as it waits on it.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired mutex.
+*
+*              timeout       is an optional timeout period (in clock ticks).  If non-zero, your task will
+*                            wait for the mutex up to the amount of time specified by this argument.
+*                            If you specify 0, however, your task will wait forever at the specified
+*                            mutex or, until the mutex is released.
+*
+*              perr          is a pointer to where an error message will be deposited.  Possible error
+*                            messages are:
+*
+*                            OS_ERR_NONE         The call was successful and your task owns the mutex.
+*                            OS_ERR_TIMEOUT      The mutex was not available within the specified 'timeout'.
+*                            OS_ERR_EVENT_TYPE   If you didn't pass a pointer to a mutex.
+*
+* Returns    : none
+* Note(s)    : The idle task must not wait on a mutex.
+*********************************************************************************************************
+*/
+void OS_Mutex_Wait(OS_EVENT  *pEvent,
+                   uint32_t  timeout,
+                   uint8_t   *pErr)
+{
+    OS_TCB     *pOwner;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    if (pEvent->OS_EventType != OS_EVENT_TYPE_MUTEX) { /* Validate event block type */
+        *pErr = OS_ERR_EVENT_TYPE;
+        return;
+    }
+    Q_REQUIRE(OS_Tcb_Curr != ReadyTaskList.TaskList[0]);
+    OS_ENTER_CRITICAL();
+    pOwner = (OS_TCB *)pEvent->OS_EventPtr;
+    if (pOwner == (OS_TCB *)0) {                       /* Mutex available, take it                  */
+        os_mutexOwnerSet(pEvent, OS_Tcb_Curr);
+        pEvent->OS_EventCnt = 1u;
+        OS_EXIT_CRITICAL();
+        *pErr = OS_ERR_NONE;
+        return;
+    }
+    if (pOwner == OS_Tcb_Curr) {                       /* Locked again by the owner                 */
+        Q_ASSERT(pEvent->OS_EventCnt < 65535u);
+        pEvent->OS_EventCnt++;
+        OS_EXIT_CRITICAL();
+        *pErr = OS_ERR_NONE;
+        return;
+    }
+
+    /* Otherwise, must wait until the owner releases the mutex */
+    OS_Tcb_Curr->OS_TcbState     |= OS_STAT_MUTEX;    /* Mutex not available, pend on mutex          */
+    OS_Tcb_Curr->OS_TcbStatePend  = OS_STAT_PEND_OK;
+    OS_Tcb_Curr->OS_TcbTimeout    = timeout;          /* Store pend timeout in TCB                   */
+    OS_Tcb_Curr->OS_TcbEcbPtr     = pEvent;           /* Store ptr to ECB in current TCB             */
+    OS_EventTaskWait(OS_Tcb_Curr);                    /* Suspend task until mutex or timeout         */
+    OS_MutexPrioUpdate(pOwner);                       /* Owner inherits priority of the waiting task */
+    OS_sched();                                       /* Find next highest priority task ready       */
+    OS_EXIT_CRITICAL();
+    if (OS_Tcb_Curr->OS_TcbStatePend == OS_STAT_PEND_TO) { /* Readied by OS_tick(), which already gave */
+        *pErr = OS_ERR_TIMEOUT;                            /* the owner its priority back              */
+        return;
+    }
+    Q_ASSERT(pEvent->OS_EventPtr == OS_Tcb_Curr);     /* The mutex is handed over by OS_Mutex_Post() */
+    *pErr = OS_ERR_NONE;
+}
+/*
+*********************************************************************************************************
+*               POST TO A MUTEX
+*
+* Description: This function releases a mutex. If tasks are waiting, the mutex is handed over to the
+*              highest priority one, so no other task can take it before the readied task runs. The
+*              releasing task goes back to its own priority, or to the highest priority waiting for the
+*              other mutexes it still owns.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired mutex.
+*
+* Returns    : OS_ERR_NONE            The call was successful and the mutex was released.
+*              OS_ERR_NOT_MUTEX_OWNER If the calling task does not own the mutex.
+*              OS_ERR_EVENT_TYPE      If you didn't pass a pointer to a mutex.
+*********************************************************************************************************
+*/
+uint8_t OS_Mutex_Post(OS_EVENT *pEvent)
+{
+    OS_TCB     *pOwner;
+    Task_List  *pWaitList;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    if (pEvent->OS_EventType != OS_EVENT_TYPE_MUTEX) { /* Validate event block type */
+        return (OS_ERR_EVENT_TYPE);
+    }
+    OS_TRACE(OS_TRACE_EV_POST, pEvent->OS_EventType, pEvent);
+    OS_ENTER_CRITICAL();
+    if (pEvent->OS_EventPtr != OS_Tcb_Curr) {
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_NOT_MUTEX_OWNER);
+    }
+    pEvent->OS_EventCnt--;
+    if (pEvent->OS_EventCnt > 0u) {                 /* Still locked by nested wait */
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_NONE);
+    }
+    os_mutexOwnerClr(pEvent);
+    pWaitList = &pEvent->OS_EventWaitList;
+    if (pWaitList->TaskGroupBitMap != 0u) {         /* Hand over to the HPT waiting on the mutex   */
+        pOwner = pWaitList->TaskList[os_utilsGetHighestPriority(pWaitList)];
+        os_mutexOwnerSet(pEvent, pOwner);
+        pEvent->OS_EventCnt = 1u;
+        (void)OS_EventTaskReady(pEvent, (void *)0, OS_STAT_MUTEX, OS_STAT_PEND_OK);
+        OS_MutexPrioUpdate(pOwner);                 /* New owner inherits from the rest waiting    */
+    }
+    OS_MutexPrioUpdate(OS_Tcb_Curr);                /* Give up the inherited priority              */
+    OS_sched();
+    OS_EXIT_CRITICAL();
+    return (OS_ERR_NONE);
+}
+/*
+*********************************************************************************************************
+*               UPDATE PRIORITY OF A MUTEX OWNER
+*
+* Description: This function sets the priority of a task to the highest of its own priority and the
+*              priorities of the tasks waiting for the mutexes it owns. If the priority is changed and the
+*              task waits on a mutex, the owner of that mutex is updated too, so the inheritance is
+*              transitive. The task is re-queued in the list it is in at its new priority.
+*
+* Arguments  : pTcb          is the task to update.
+*
+* Returns    : none
+* Note(s)    : Each step walks only the mutexes the task owns, from OS_TcbMutexOwned. A mutex has one
+*              owner and the chain of owners is at most OS_MAX_EVENTS long, so the cost is bounded by
+*              OS_MAX_EVENTS, and it does not depend on the number of tasks. It is called with interrupts
+*              disabled, by the mutex services and by OS_EventTaskRemove() when a waiter times out.
+*********************************************************************************************************
+*/
+void OS_MutexPrioUpdate(OS_TCB *pTcb)
+{
+    OS_EVENT  *pEvent;
+    uint8_t   prio;
+    uint8_t   waitPrio;
+    uint16_t  chain;
+
+    for (chain = 0u; (pTcb != (OS_TCB *)0) && (chain < OS_MAX_EVENTS); chain++) {
+        prio = pTcb->OS_TcbBasePrio;
+        for (pEvent = pTcb->OS_TcbMutexOwned; pEvent != (OS_EVENT *)0; pEvent = pEvent->OS_EventMutexNext) {
+            if (pEvent->OS_EventWaitList.TaskGroupBitMap != 0u) { /* Highest task waiting for it */
+                waitPrio = os_utilsGetHighestPriority(&pEvent->OS_EventWaitList);
+                if (waitPrio > prio) {
+                    prio = waitPrio;
+                }
+            }
+        }
+        if (prio == pTcb->OS_TcbPrio) {             /* Nothing changed, the owners after it neither */
+            return;
+        }
+        os_utilsChangeTaskPrio(pTcb, prio);
+        pEvent = pTcb->OS_TcbEcbPtr;
+        if ((pEvent == (OS_EVENT *)0) || (pEvent->OS_EventType != OS_EVENT_TYPE_MUTEX)) {
+            return;
+        }
+        pTcb = (OS_TCB *)pEvent->OS_EventPtr;       /* The task waits on a mutex, update its owner  */
+    }
+}
+/*
+*********************************************************************************************************
+*               SET AND CLEAR THE OWNER OF A MUTEX
+*
+* Description: os_mutexOwnerSet() makes a task the owner of a mutex, and adds the mutex to the front of the
+*              mutexes the task owns. os_mutexOwnerClr() removes the mutex from the mutexes of its owner
+*              and leaves it without owner. Nested mutexes are released in the reverse order, so the
+*              released mutex is normally the first one and the walk stops at once.
+*
+* Arguments  : pEvent        is the mutex.
+*
+*              pTcb          is the new owner.
+*
+* Returns    : none
+* Note(s)    : They are called with interrupts disabled.
+*********************************************************************************************************
+*/
+static void os_mutexOwnerSet(OS_EVENT *pEvent, OS_TCB *pTcb)
+{
+    pEvent->OS_EventPtr       = pTcb;
+    pEvent->OS_EventMutexNext = pTcb->OS_TcbMutexOwned;
+    pTcb->OS_TcbMutexOwned    = pEvent;
+}
+
+static void os_mutexOwnerClr(OS_EVENT *pEvent)
+{
+    OS_EVENT  **ppEvent;
+
+    ppEvent = &((OS_TCB *)pEvent->OS_EventPtr)->OS_TcbMutexOwned;
+    while (*ppEvent != pEvent) {
+        Q_ASSERT(*ppEvent != (OS_EVENT *)0);
+        ppEvent = &(*ppEvent)->OS_EventMutexNext;
+    }
+    *ppEvent = pEvent->OS_EventMutexNext;
+    pEvent->OS_EventMutexNext = (OS_EVENT *)0;
+    pEvent->OS_EventPtr       = (void *)0;
+}
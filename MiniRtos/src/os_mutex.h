@@ -0,0 +1,7 @@
+#ifndef __OS_MUTEX_H__
+#define __OS_MUTEX_H__
+#include "os.h"
+
+void OS_MutexPrioUpdate(OS_TCB *pTcb);
+
+#endif /* __OS_MUTEX_H__ */
@@ -23,6 +23,8 @@
 #include "os.h"
 #include "qassert.h"
 #include "os_utils_list.h"
+#include "os_utils_event.h"
+#include "os_tmr.h"
 #include "os_sched.h" 
 
 Q_DEFINE_THIS_FILE
@@ -31,8 +33,22 @@ Q_DEFINE_THIS_FILE
 extern OS_TCB * volatile OS_Tcb_Curr; /* pointer to the current thread */
 extern OS_TCB * volatile OS_Tcb_Next; /* pointer to the next thread to run */
 
-extern Task_List WaitingTaskList;
 static OS_TCB *os_schedGetNextTaskToRun();
+static uint8_t os_schedTimeSlice(uint32_t ticks);
+
+volatile uint32_t OS_TickCtr;  /* ticks since OS_Run() */
+
+#if OS_CPU_USAGE_EN != 0
+static void os_schedCpuCharge(OS_TCB *nextTcb);
+static void os_schedCpuWindow(void);
+
+static OS_TCB *os_cpuRunTcb;   /* task the time since os_cpuTs is charged to */
+static uint32_t os_cpuTs;      /* timestamp of the last task switch or window end */
+static uint32_t os_cpuWin;     /* number of the current window */
+static uint32_t os_cpuWinTick; /* tick the current window started */
+static uint32_t os_cpuWinTs;   /* timestamp the current window started */
+static uint32_t os_cpuWinLen;  /* length of the last complete window, in timestamp units */
+#endif
 
 /*
 *********************************************************************************************************
@@ -57,15 +73,21 @@ void OS_sched(void) {
     OS_CPU_SR  cpu_sr = 0u;
     
     OS_ENTER_CRITICAL();
-    if (ReadyTaskList.TaskRriorityBitMap == 0U) { /* idle condition? */
-        nextTcb = ReadyTaskList.TaskList[0]->pTcb; /* the idle thread */
+    if (ReadyTaskList.TaskGroupBitMap == 0U) { /* idle condition? */
+        nextTcb = ReadyTaskList.TaskList[0]; /* the idle thread */
     }
     else {
         nextTcb = os_schedGetNextTaskToRun();
         Q_ASSERT(nextTcb);
     }
+#if OS_CPU_USAGE_EN != 0
+    if (nextTcb != os_cpuRunTcb) {
+        os_schedCpuCharge(nextTcb);
+    }
+#endif
     /* trigger PendSV, if needed */
     if (nextTcb != OS_Tcb_Curr) {
+        OS_TRACE(OS_TRACE_EV_SWITCH, nextTcb->OS_TcbPrio, nextTcb);
         OS_Tcb_Next = nextTcb;
         TRIGER_PENDSV_INT();
         //*(uint32_t volatile *)0xE000ED04 = (1U << 28);
@@ -84,60 +106,291 @@ void OS_sched(void) {
 *
 * Arguments  : None
 **
-* Returns    : None
+* Returns    : uint8_t     not 0 if a task was readied or the time slice rotated the tasks, so OS_sched()
+*                          is needed. 0 if the task to run is unchanged.
 * Note(s)    : This utility function is called by other functions in OS,and should not be used by applications.
                
 *********************************************************************************************************
 */
-void OS_tick(void) {
-    uint32_t workingSet;
-    Task_List_Node *tempTask;
-    Task_List_Node *pTask;    
-    uint8_t index;
-    uint32_t bit;
-    OS_TCB *pTcp;
-
-    workingSet = DelayedTaskList.TaskRriorityBitMap;
-    while (workingSet != 0U) {
-        index  = LOG2(workingSet);
-        tempTask = DelayedTaskList.TaskList[index];
-        pTcp = tempTask->pTcb;
-        Q_ASSERT((pTcp!= (OS_TCB *)0) && (pTcp->OS_TcbTimeout != 0U));
-        bit = (1U << (pTcp->OS_TcbPrio - 1U));
-        if(tempTask->next == 0 ){ /* only one task in the priority group */
-             pTcp->OS_TcbTimeout--;
-            if (pTcp->OS_TcbTimeout == 0U){
-                pTask = os_utilsRemoveFromListByTaskNode(tempTask, DELAYED_TASK_LIST);
-                Q_ASSERT(pTask);
-                os_utilsAddTaskToListByNode(pTask, READY_TASK_LIST);
-            }
-        }else{ /* this prority group has more than one tasks */
-            while(tempTask!= 0){
-                pTcp = tempTask->pTcb;
-                pTcp->OS_TcbTimeout--;
-                if (pTcp->OS_TcbTimeout == 0U) {
-                    pTask = os_utilsRemoveFromListByTaskNode(tempTask, DELAYED_TASK_LIST);
-                    Q_ASSERT(pTask);
-                    os_utilsAddTaskToListByNode(pTask, READY_TASK_LIST);
-                }
-                tempTask = tempTask->next;
-            }    
+uint8_t OS_tick(void) {
+    return OS_tickAdvance(1U);
+}
+
+/*
+*********************************************************************************************************
+*             OS tick advance
+*
+* Description: This function advances the OS tick count by a number of ticks in one step, and moves
+*              all the tasks timeout in these ticks from DelayedTaskList to ReadyTaskList. 
+*              DelayedTaskList is a delta list, so only the first task is decremented. The tasks after it
+*              with 0 ticks left wake up at the same tick. The cost does not depend on how many tasks
+*              are delayed, only on how many tasks wake up. A timeout task waiting on an event is removed
+*              from the wait list of the event, and its OS_TcbStatePend is set to OS_STAT_PEND_TO.
+*
+* Arguments  : ticks   number of ticks elapsed
+**
+* Returns    : uint8_t not 0 if a task was readied or the time slice rotated the tasks, 0 if not.
+* Note(s)    : This function is called by OS_tick(), and by the BSP tickless idle after a long sleep
+*              with the ticks slept. It does not call OS_sched(), the caller does if it returns not 0.
+*              The timer task is readied by a semaphore post, which schedules by itself.
+*********************************************************************************************************
+*/
+uint8_t OS_tickAdvance(uint32_t ticks) {
+    OS_TCB *pTcb;
+    uint8_t changed;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    OS_TickCtr += ticks;
+#if OS_CPU_USAGE_EN != 0
+    if ((OS_TickCtr - os_cpuWinTick) >= OS_CPU_USAGE_WINDOW) {
+        os_schedCpuWindow();
+    }
+#endif
+    changed = os_schedTimeSlice(ticks);
+    OS_TmrTick(ticks);
+    pTcb = DelayedTaskList.DelayedTaskHead;
+    while ((pTcb != 0) && ((ticks != 0U) || (pTcb->OS_TcbTimeout == 0U))) {
+        if (pTcb->OS_TcbTimeout > ticks) {
+            pTcb->OS_TcbTimeout -= ticks; /* not timeout yet */
+            break;
+        }
+        ticks -= pTcb->OS_TcbTimeout;
+        pTcb->OS_TcbTimeout = 0U;
+        pTcb = os_utilsRemoveFromDelayedListHead();
+        Q_ASSERT(pTcb);
+        if (pTcb->OS_TcbEcbPtr != (OS_EVENT *)0) { /* wait on event timeout */
+            OS_EventTaskRemove(pTcb);
+        }
+        os_utilsAddTaskToListByTcb(pTcb, &ReadyTaskList);
+        OS_TRACE(OS_TRACE_EV_TIMEOUT, pTcb->OS_TcbPrio, pTcb);
+        changed = 1U;
+        pTcb = DelayedTaskList.DelayedTaskHead;
+    }
+    OS_EXIT_CRITICAL();
+    return changed;
+}
+
+/*
+*********************************************************************************************************
+*             Time slice
+*
+* Description: This function counts down the time slice of the running task. When the time slice is used
+*              up, the task gets a new one, and its priority link list is rotated, so the next task of same
+*              priority runs at the next OS_sched(). The idle task, the OS_EDF_PRIO tasks, which are ordered
+*              by deadline, and a task which is not ready any more (it is being switched out) have no time
+*              slice.
+*
+* Arguments  : ticks   number of ticks elapsed
+**
+* Returns    : uint8_t not 0 if the tasks of the priority were rotated to another task
+* Note(s)    : This function is called by OS_tickAdvance() with interrupts disabled.
+*********************************************************************************************************
+*/
+static uint8_t os_schedTimeSlice(uint32_t ticks) {
+    OS_TCB *pTcb;
+
+    pTcb = OS_Tcb_Curr;
+    if ((pTcb == (OS_TCB *)0) || (pTcb->OS_TcbPrio == 0U) || (pTcb->OS_TcbState != 0U)) {
+        return 0U;
+    }
+#if OS_EDF_PRIO != 0
+    if (pTcb->OS_TcbPrio == OS_EDF_PRIO) {
+        return 0U;
+    }
+#endif
+    if (pTcb->OS_TcbTimeQuantaCtr > ticks) {
+        pTcb->OS_TcbTimeQuantaCtr -= ticks;
+        return 0U;
+    }
+    pTcb->OS_TcbTimeQuantaCtr = pTcb->OS_TcbTimeQuanta;
+    if ((ReadyTaskList.TaskList[pTcb->OS_TcbPrio] != pTcb) || (pTcb->OS_TcbNext == pTcb)) {
+        return 0U;                        /* Not the first one, or the only one of its priority */
+    }
+    (void)os_utilsRotateTaskList(&ReadyTaskList, pTcb->OS_TcbPrio);
+    return 1U;
+}
+
+#if OS_CPU_USAGE_EN != 0
+/*
+*********************************************************************************************************
+*             CPU usage, charge the running task
+*
+* Description: This function adds the time since the last task switch to the task which ran, and starts
+*              counting the time of nextTcb. A task counts its time in the current window, so when it
+*              runs first in a new window, the time of its last window is kept in OS_TcbCpuTimePrev and
+*              the count starts again. A task which did not run in the window before gets 0.
+*
+* Arguments  : nextTcb   the task to charge from now, the running task at the end of a window
+**
+* Returns    : None
+* Note(s)    : This function is called by OS_sched() when the task to run changes, with interrupts
+*              disabled. The time between OS_sched() and PendSV_Handler is charged to the next task.
+*********************************************************************************************************
+*/
+static void os_schedCpuCharge(OS_TCB *nextTcb) {
+    OS_TCB *pTcb;
+    uint32_t now;
+
+    now = OS_CPU_TS_GET();
+    pTcb = os_cpuRunTcb;
+    if (pTcb != (OS_TCB *)0) {
+        if (pTcb->OS_TcbCpuWin != os_cpuWin) {
+            pTcb->OS_TcbCpuTimePrev = ((pTcb->OS_TcbCpuWin + 1U) == os_cpuWin) ? pTcb->OS_TcbCpuTime : 0U;
+            pTcb->OS_TcbCpuTime = 0U;
+            pTcb->OS_TcbCpuWin = os_cpuWin;
         }
-        workingSet &= ~bit; /* remove from working set */
+        pTcb->OS_TcbCpuTime += now - os_cpuTs;
+    }
+    else {                                      /* the first task switch, by OS_Run() */
+        os_cpuWinTs = now;
+        os_cpuWinTick = OS_TickCtr;
     }
+    os_cpuTs = now;
+    os_cpuRunTcb = nextTcb;
+}
+
+/*
+*********************************************************************************************************
+*             CPU usage, end of a window
+*
+* Description: This function ends the current window. The running task is charged up to now, the length
+*              of the window is saved, and a new window starts. The other tasks move their counts to the
+*              new window when they run, see os_schedCpuCharge(), so the cost does not depend on the
+*              number of tasks.
+*
+* Arguments  : None
+**
+* Returns    : None
+* Note(s)    : This function is called by OS_tickAdvance() with interrupts disabled. After a tickless
+*              sleep longer than a window, the window is as long as the sleep.
+*********************************************************************************************************
+*/
+static void os_schedCpuWindow(void) {
+    os_schedCpuCharge(os_cpuRunTcb);
+    os_cpuWinLen = os_cpuTs - os_cpuWinTs;
+    os_cpuWinTs = os_cpuTs;
+    os_cpuWinTick = OS_TickCtr;
+    os_cpuWin++;
+}
+
+/*
+*********************************************************************************************************
+*             QUERY THE CPU USAGE OF A TASK
+*
+* Description: This function returns the time a task ran in the last complete window of
+*              OS_CPU_USAGE_WINDOW ticks, and its load in per mille of the window. The time in interrupts
+*              is charged to the task they interrupted. Before the first window ends, all is 0.
+*
+* Arguments  : pTcb      is a pointer to the task, or 0 for the idle task.
+*
+*              pData     is a pointer to where the usage is copied.
+*
+* Returns    : OS_ERR_NONE
+*********************************************************************************************************
+*/
+uint8_t OS_Task_CpuQuery(OS_TCB *pTcb, OS_TASK_CPU_DATA *pData) {
+    uint32_t time;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    Q_REQUIRE(pData != (OS_TASK_CPU_DATA *)0);
+    if (pTcb == (OS_TCB *)0) {
+        pTcb = ReadyTaskList.TaskList[0];       /* the idle task */
+    }
+    OS_ENTER_CRITICAL();
+    if (pTcb->OS_TcbCpuWin == os_cpuWin) {
+        time = pTcb->OS_TcbCpuTimePrev;
+    }
+    else if ((pTcb->OS_TcbCpuWin + 1U) == os_cpuWin) {
+        time = pTcb->OS_TcbCpuTime;             /* not run since the window ended */
+    }
+    else {
+        time = 0U;
+    }
+    pData->OS_CpuTime = time;
+    pData->OS_CpuWindow = os_cpuWinLen;
+    OS_EXIT_CRITICAL();
+    pData->OS_CpuLoad = (os_cpuWinLen != 0U) ? (uint16_t)(((uint64_t)time * 1000U) / os_cpuWinLen) : 0U;
+    return (OS_ERR_NONE);
+}
+
+/*
+*********************************************************************************************************
+*             CPU LOAD
+*
+* Description: This function returns the load of the CPU in the last complete window, the time not in
+*              the idle task.
+*
+* Arguments  : None
+**
+* Returns    : uint16_t    CPU load in per mille, 0 before the first window ends
+*********************************************************************************************************
+*/
+uint16_t OS_CpuLoad(void) {
+    OS_TASK_CPU_DATA idle;
+
+    (void)OS_Task_CpuQuery((OS_TCB *)0, &idle);
+    if (idle.OS_CpuWindow == 0U) {
+        return 0U;
+    }
+    return (idle.OS_CpuLoad < 1000U) ? (uint16_t)(1000U - idle.OS_CpuLoad) : 0U;
+}
+#endif
+
+/*
+*********************************************************************************************************
+*             OS tick next timeout
+*
+* Description: This function returns the ticks left to the earliest timeout in DelayedTaskList or of the
+*              running timers. The BSP tickless idle uses it to decide how long to sleep.
+*
+* Arguments  : None
+**
+* Returns    : uint32_t    ticks to the next timeout, or NO_TIMEOUT if no task is delayed and no timer
+*                          is running
+* Note(s)    : This function should be called with interrupts disabled, so the result is still valid
+*              when the timer is reprogrammed.
+*********************************************************************************************************
+*/
+uint32_t OS_tickNextTimeout(void) {
+    uint32_t ticks;
+    uint32_t tmrTicks;
+
+    ticks = NO_TIMEOUT;
+    if (DelayedTaskList.DelayedTaskHead != 0) {
+        ticks = DelayedTaskList.DelayedTaskHead->OS_TcbTimeout;
+    }
+    tmrTicks = OS_TmrNextTimeout();
+    if (tmrTicks < ticks) {
+        ticks = tmrTicks;
+    }
+    return ticks;
+}
+
+/*
+*********************************************************************************************************
+*             OS time get
+*
+* Description: This function returns the number of ticks since OS_Run().
+*
+* Arguments  : None
+**
+* Returns    : uint32_t    current OS tick count
+*********************************************************************************************************
+*/
+uint32_t OS_TimeGet(void) {
+    return OS_TickCtr;
 }
 /*
 *********************************************************************************************************
 *             Get Next Task To Run
 *
 * Description: This function pick up next highest task to run, but not remove the task from Reay List 
-*              and bit map. It is round robin among same priority tasks. 
-*              The macro LOG2(ReadyTaskList.TaskRriorityBitMap) guarantees to return the index for the 
-*              highest priority task link list. If currnet running task in the link list, it will reutn 
-*              next one, or next one doesn't exist, it will return the firet one in the link list. May be
-*              the running one itself if there is only one task in the link list. We do not need to loop 
-*              over whole ReadyTaskList set becuase LOG2(ReadyTaskList.TaskRriorityBitMap) guarantees 
-*              to return one task in the priority list.
+*              and bit map. os_utilsGetHighestPriority(&ReadyTaskList) guarantees to return the index for
+*              the highest priority task link list. The first task of the link list is the one to run.
+*              The link list is only rotated when the running task used up its time slice, see
+*              os_schedTimeSlice(), or called OS_Yield(), so scheduling again in the time slice keeps
+*              running the same task.
 *
 * Arguments  : None
 **
@@ -148,37 +401,12 @@ void OS_tick(void) {
 OS_TCB *os_schedGetNextTaskToRun(){
     uint8_t index;
     OS_TCB *nextTcb;
-    Task_List_Node *nextTask;
     OS_CPU_SR  cpu_sr = 0u;
     
     OS_ENTER_CRITICAL();
-    index = LOG2(ReadyTaskList.TaskRriorityBitMap);
-    nextTask = ReadyTaskList.TaskList[index];
-    Q_ASSERT(nextTask);
-    while (nextTask){
-        nextTcb = nextTask->pTcb;
-        if( nextTcb == OS_Tcb_Curr ){
-            /* if current running task found, we either return next one, if exist. 
-               Or if next one does not exist, we return the first one, it may be current one itself 
-               if current one is the only one in the ready list */            
-            if(nextTask->next != 0){
-                nextTask = nextTask->next;
-            }
-            else {
-                nextTask = ReadyTaskList.TaskList[index]; /* Loop back to first one */
-            }
-            nextTcb = nextTask->pTcb;
-            OS_EXIT_CRITICAL();
-            return nextTcb;
-        }
-        /* current running one not found, we look for next */
-        nextTask = nextTask->next;
-    }
-    /* When reach here, no current running tcb found in the highest priority task link list,
-       the curret running one may be in lower priority task link list, then we return first 
-       one in the highest priority task link list. */
-    nextTask = ReadyTaskList.TaskList[index];
-    nextTcb = nextTask->pTcb;
+    index = os_utilsGetHighestPriority(&ReadyTaskList);
+    nextTcb = ReadyTaskList.TaskList[index];
+    Q_ASSERT(nextTcb);
     OS_EXIT_CRITICAL();
     return nextTcb;
 }
@@ -187,9 +415,10 @@ OS_TCB *os_schedGetNextTaskToRun(){
 *             Sys Tick Handler
 *
 * Description: This function is called every system tick. It calls OS_tick(). OS_tick() checks if there is
-*              any suspend task timeouot. Regardless if there is any suspend task timeout, it will call
-*              OS_sched() to schdule next task to run. The next task could be one of timeout suspend task.
-*              same prioirty task round robin, etc.
+*              any suspend task timeouot. Only if a task timeout or the time slice of the running task is
+*              used up, it will call OS_sched() to schdule next task to run. The next task could be one of
+*              timeout suspend task, or the next task of same priority. Otherwise the running task keeps
+*              running, and the tick costs no scheduling.
 *
 * Arguments  : None
 **
@@ -202,10 +431,12 @@ void SysTick_Handler(void) {
      OS_CPU_SR  cpu_sr = 0u;
 
     //GPIOF_AHB->DATA_Bits[TEST_PIN] = TEST_PIN;
-    OS_tick();
-    
-    OS_ENTER_CRITICAL();
-    OS_sched();
-    OS_EXIT_CRITICAL();
+    OS_TRACE_ISR_ENTER(15U);               /* SysTick exception number */
+    if (OS_tick() != 0U) {
+        OS_ENTER_CRITICAL();
+        OS_sched();
+        OS_EXIT_CRITICAL();
+    }
+    OS_TRACE_ISR_EXIT(15U);
     //GPIOF_AHB->DATA_Bits[TEST_PIN] = 0U;
 }
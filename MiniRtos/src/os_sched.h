@@ -23,8 +23,8 @@
 #include <stdint.h>
 #include "os.h"
 
-/* process all timeouts */
-void OS_tick(void);
+/* process all timeouts, returns not 0 if the ready tasks may have changed */
+uint8_t OS_tick(void);
 void OS_sched(void);
 
 #endif /* _OS_SCHED_H_ */
@@ -58,7 +58,7 @@ OS_EVENT *OS_Sem_Create (uint16_t cnt,char *se_name)
         pEvent->OS_EventCnt     = cnt;              /* Set semaphore value        */
         pEvent->OS_EventPtr     = (void *)0;        /* Unlink from ECB free list  */
         pEvent->OS_EventName    = se_name;
-        //OS_EventWaitListInit(pEvent);             /* Initialize to 'nobody waiting' on sem. */
+        OS_EventWaitListInit(pEvent);               /* Initialize to 'nobody waiting' on sem. */
     }
     return (pEvent);
 }
@@ -119,6 +119,10 @@ void OS_Sem_Wait(OS_EVENT  *pEvent,
     OS_EventTaskWait(OS_Tcb_Curr);             /* Suspend task until event or timeout occurs  */
     OS_sched();                                       /* Find next highest priority task ready       */
     OS_EXIT_CRITICAL();
+    if (OS_Tcb_Curr->OS_TcbStatePend == OS_STAT_PEND_TO) { /* Readied by OS_tick(), not by a post      */
+        *pErr = OS_ERR_TIMEOUT;
+        return;
+    }
     *pErr = OS_ERR_NONE;
 }
 /*
@@ -144,8 +148,9 @@ uint8_t OS_Sem_Post (OS_EVENT *pEvent)
     if (pEvent->OS_EventType != OS_EVENT_TYPE_SEM) {   /* Validate event block type */
         return (OS_ERR_EVENT_TYPE);
     }
+    OS_TRACE(OS_TRACE_EV_POST, pEvent->OS_EventType, pEvent);
     OS_ENTER_CRITICAL();
-    if (WaitingTaskList.TaskRriorityBitMap != 0u) { /* See if any task waiting for semaphore */
+    if (pEvent->OS_EventWaitList.TaskGroupBitMap != 0u) { /* See if any task waiting for semaphore */
         /* Ready HPT waiting on event */
         (void)OS_EventTaskReady(pEvent, (void *)0, OS_STATE_SEM, OS_STAT_PEND_OK);
         OS_sched();       /* Find next highest priority task ready */ /* Find HPT ready to run */
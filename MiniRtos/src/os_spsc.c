@@ -0,0 +1,172 @@
+/****************************************************************************
+* Mini Real-time Operating System (MiniRTOS)
+* version 1.0 2025
+*
+* This software is to illustrate the concepts of Real-Time Operating System (RTOS).
+* This MiniRTOS program is designed to use Array and Bit Map to implement Task List
+* to speed up task search time. Therefore, the task priority is limited 0-31. It allows
+* same priority has more than one tasks. The same priority tasks are arranged with link list.
+* For most applications, few tasks need at same priority. Therefore the same priority task
+* link list should be short, and its search time and variant should be acceptable.
+*
+* This program is under the terms of the GNU General Public License as published by
+* the Free Software Foundation. This program does not have ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See GNU General Public License <https://www.gnu.org/licenses/> for more details.
+*
+* Git repo:
+*
+****************************************************************************/
+
+#include "os.h"
+
+/*
+*********************************************************************************************************
+*              CREATE A LOCK-FREE SPSC RING
+*
+* Description: This function initializes a ring to pass 32-bit items from one producer, usually an ISR,
+*              to one consumer task without disabling interrupts. The producer and the consumer each
+*              write their own index only, and the barriers order the item and the index, so no critical
+*              section is needed to put or get an item.
+*
+* Arguments  : pRing     is a pointer to the ring, allocated by the application.
+*
+*              buf       is the storage of 'size' items.
+*
+*              size      is the number of items, it must be a power of 2.
+*
+*              wake      if not 0, a semaphore is created to wake the consumer, so it can wait with
+*                        OS_Spsc_Pend(). The semaphore is only posted when the ring becomes not empty.
+*
+* Returns    : OS_ERR_NONE     The ring is initialized.
+*              OS_ERR_OTHER    'size' is not a power of 2, or no event control block for the semaphore.
+* Note(s)    : Only one producer and one consumer may use a ring.
+*********************************************************************************************************
+*/
+uint8_t OS_Spsc_Create(OS_SPSC *pRing, uint32_t *buf, uint32_t size, uint8_t wake)
+{
+    if ((size < 2u) || ((size & (size - 1u)) != 0u)) {
+        return (OS_ERR_OTHER);
+    }
+    pRing->OS_SpscBuf  = buf;
+    pRing->OS_SpscMask = size - 1u;
+    pRing->OS_SpscHead = 0u;
+    pRing->OS_SpscTail = 0u;
+    pRing->OS_SpscSem  = (OS_EVENT *)0;
+    if (wake != 0u) {
+        pRing->OS_SpscSem = OS_Sem_Create(0u, "spsc");
+        if (pRing->OS_SpscSem == (OS_EVENT *)0) {
+            return (OS_ERR_OTHER);
+        }
+    }
+    return (OS_ERR_NONE);
+}
+
+/*
+*********************************************************************************************************
+*              PUT AN ITEM TO A LOCK-FREE SPSC RING
+*
+* Description: This function is called by the producer to put an item. It does not disable interrupts.
+*              The item is written before the head is moved, so the consumer never sees the head before
+*              the item. If the consumer has got all the items before this one, the ring was empty and
+*              the consumer may be waiting, so it is signaled. The tail is read after the head is moved,
+*              so a consumer which empties the ring at the same time either sees the new item, or is
+*              signaled.
+*
+* Arguments  : pRing     is a pointer to the ring.
+*
+*              item      is the item to put.
+*
+* Returns    : OS_ERR_NONE     The item is put.
+*              OS_ERR_Q_FULL   The ring is full, the item is dropped.
+*********************************************************************************************************
+*/
+uint8_t OS_Spsc_Put(OS_SPSC *pRing, uint32_t item)
+{
+    uint32_t head;
+
+    head = pRing->OS_SpscHead;
+    if ((head - pRing->OS_SpscTail) > pRing->OS_SpscMask) { /* Full */
+        return (OS_ERR_Q_FULL);
+    }
+    pRing->OS_SpscBuf[head & pRing->OS_SpscMask] = item;
+    OS_CPU_DMB();                                 /* Item written before it is published */
+    pRing->OS_SpscHead = head + 1u;
+    if (pRing->OS_SpscSem != (OS_EVENT *)0) {
+        OS_CPU_DMB();                             /* Head published before the tail is read */
+        if (pRing->OS_SpscTail == head) {         /* It was empty, the consumer may wait */
+            (void)OS_Sem_Post(pRing->OS_SpscSem);
+        }
+    }
+    return (OS_ERR_NONE);
+}
+
+/*
+*********************************************************************************************************
+*              GET AN ITEM FROM A LOCK-FREE SPSC RING
+*
+* Description: This function is called by the consumer to get an item without waiting. It does not
+*              disable interrupts.
+*
+* Arguments  : pRing     is a pointer to the ring.
+*
+*              pItem     is a pointer to where the item is copied.
+*
+* Returns    : OS_ERR_NONE     An item is got.
+*              OS_ERR_Q_EMPTY  The ring is empty.
+*********************************************************************************************************
+*/
+uint8_t OS_Spsc_Get(OS_SPSC *pRing, uint32_t *pItem)
+{
+    uint32_t tail;
+
+    tail = pRing->OS_SpscTail;
+    if (pRing->OS_SpscHead == tail) {             /* Empty */
+        return (OS_ERR_Q_EMPTY);
+    }
+    OS_CPU_DMB();                                 /* Head read before the item */
+    *pItem = pRing->OS_SpscBuf[tail & pRing->OS_SpscMask];
+    OS_CPU_DMB();                                 /* Item read before the slot is freed */
+    pRing->OS_SpscTail = tail + 1u;
+    OS_CPU_DMB();                                 /* Tail published before the head is read again */
+    return (OS_ERR_NONE);
+}
+
+/*
+*********************************************************************************************************
+*              WAIT FOR AN ITEM FROM A LOCK-FREE SPSC RING
+*
+* Description: This function is called by the consumer to get an item, and waits on the semaphore of the
+*              ring if it is empty. The ring must be created with 'wake'.
+*
+* Arguments  : pRing     is a pointer to the ring.
+*
+*              pItem     is a pointer to where the item is copied.
+*
+*              timeout   is an optional timeout period (in clock ticks) of each wait. 0 waits forever.
+*
+*              perr      is a pointer to where an error message will be deposited:
+*
+*                        OS_ERR_NONE         An item is got.
+*                        OS_ERR_TIMEOUT      No item was put within the specified 'timeout'.
+*                        OS_ERR_OTHER        The ring has no semaphore.
+*
+* Returns    : none
+* Note(s)    : The semaphore may be posted for an item got already, then the consumer wakes up and finds
+*              the ring empty, and waits again.
+*********************************************************************************************************
+*/
+void OS_Spsc_Pend(OS_SPSC *pRing, uint32_t *pItem, uint32_t timeout, uint8_t *pErr)
+{
+    if (pRing->OS_SpscSem == (OS_EVENT *)0) {
+        *pErr = OS_ERR_OTHER;
+        return;
+    }
+    while (OS_Spsc_Get(pRing, pItem) != OS_ERR_NONE) {
+        OS_Sem_Wait(pRing->OS_SpscSem, timeout, pErr);
+        if (*pErr != OS_ERR_NONE) {
+            return;
+        }
+    }
+    *pErr = OS_ERR_NONE;
+}
@@ -24,17 +24,29 @@
 #include "os_sched.h"
 #include "os_utils_event.h"
 #include "os_msg_q.h"
+#include "os_tmr.h"
+#include "os_mem.h"
 Q_DEFINE_THIS_FILE
 
 OS_TCB * volatile OS_Tcb_Curr; /* pointer to the current task */
 OS_TCB * volatile OS_Tcb_Next; /* pointer to the next task to run */
 
 Task_List ReadyTaskList;
-Task_List DelayedTaskList;
-Task_List WaitingTaskList;
+Delayed_Task_List DelayedTaskList;
 
  
 OS_TCB idleTask;
+
+static OS_TCB *os_taskCreatedList;  /* all the tasks created, linked by OS_TcbCreatedNext */
+
+#if OS_STK_SCAN_WORDS != 0
+static void os_taskStkScan(void);
+
+static OS_TCB *os_stkScanTcb;       /* task the background stack scan is in, 0 to start again */
+static uint32_t *os_stkScanPtr;     /* next word of its stack to scan */
+#endif
+
+static void os_taskStkFreeSet(OS_TCB *pTcb, uint32_t freeWords);
 /*
 *********************************************************************************************************
 *              main Idle Task
@@ -46,10 +58,14 @@ OS_TCB idleTask;
 * Returns    : None
 *
 * Note       : The application callback function OS_OnIdle() is good place to add power saving funtionality.
+*              Before it, a part of the stacks is scanned for the stack usage, see os_taskStkScan().
 *********************************************************************************************************
 */
 void main_idleTask() { 
     while (1) {
+#if OS_STK_SCAN_WORDS != 0
+        os_taskStkScan();
+#endif
         OS_OnIdle();
     }
 }
@@ -70,15 +86,21 @@ void main_idleTask() {
 void OS_Init(void *stkSto, uint32_t stkSize) {
     /* set the PendSV interrupt priority to the lowest level 0xFF */
     SET_PENDSV_INT_PRIO_TO_LOWEST_LEVEL();
+    /* the exception stack the interrupts run on once tasks run on their own stacks */
+    OS_CPU_Init();
 
     OS_InitEventList();
     OS_MsgQ_Init();
+    OS_MsgCQ_Init();
+    OS_MemPool_Init();
     os_utilsTaskListInit();
     /* start idleTask */
     OS_Task_Create(&idleTask,
                    0U, /* idle task priority */
                    &main_idleTask,
                    stkSto, stkSize);
+    /* timer task and its semaphore */
+    OS_Tmr_Init();
 }
 
 /*
@@ -112,8 +134,9 @@ void OS_Run(void) {
 *
 * Description: This function delays/suspends current task for a period of time. It moves currrent task 
 *              from Ready Task List to Delayed Task List, and then reschedule the next task to run.
+*              The task is inserted in Delayed Task List by its wake up tick.
 *
-* Arguments  : ticks  Ticks to delayed
+* Arguments  : ticks  Ticks to delayed, must not be 0
 *
 * Returns    : None
 *
@@ -121,17 +144,141 @@ void OS_Run(void) {
 *********************************************************************************************************
 */
 void OS_Delay(uint32_t ticks) {
-    Task_List_Node *tempTask;
     /* never call OS_delay from the idleTask */
-    Q_REQUIRE(OS_Tcb_Curr != ReadyTaskList.TaskList[0]->pTcb);
+    Q_REQUIRE(OS_Tcb_Curr != ReadyTaskList.TaskList[0]);
+    Q_REQUIRE(ticks != 0U);
 
     OS_Tcb_Curr->OS_TcbTimeout = ticks;
-    tempTask = os_utilsRemoveFromListByTaskTcb(OS_Tcb_Curr, READY_TASK_LIST);
-    Q_ASSERT(tempTask);
-    os_utilsAddTaskToDelayedListByNode(tempTask);
+    OS_TRACE(OS_TRACE_EV_BLOCK, OS_STAT_DLY, ticks);
+    os_utilsRemoveFromListByTaskTcb(OS_Tcb_Curr, &ReadyTaskList);
+    os_utilsAddTaskToDelayedListByTcb(OS_Tcb_Curr);
     OS_sched();
 }
 
+/*
+*********************************************************************************************************
+*              OS Yield
+*
+* Description: This function gives the rest of the time slice of the current task to the next ready task
+*              of same priority. The current task becomes the last one of its priority, and gets a new
+*              time slice when it runs again. If no other task of same priority is ready, the current task
+*              keeps running. An OS_EDF_PRIO task keeps running too, its order is by deadline.
+*
+* Arguments  : None
+*
+* Returns    : None
+*
+* Note       : 
+*********************************************************************************************************
+*/
+void OS_Yield(void) {
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    OS_Tcb_Curr->OS_TcbTimeQuantaCtr = OS_Tcb_Curr->OS_TcbTimeQuanta;
+    if ((ReadyTaskList.TaskList[OS_Tcb_Curr->OS_TcbPrio] == OS_Tcb_Curr)
+        && ((OS_EDF_PRIO == 0) || (OS_Tcb_Curr->OS_TcbPrio != OS_EDF_PRIO))) {
+        (void)os_utilsRotateTaskList(&ReadyTaskList, OS_Tcb_Curr->OS_TcbPrio);
+    }
+    OS_sched();
+    OS_EXIT_CRITICAL();
+}
+
+/*
+*********************************************************************************************************
+*              OS Task Set Time Quanta
+*
+* Description: This function sets the round robin time slice of a task, the ticks it runs before the next
+*              ready task of same priority runs. A longer time slice means less context switches among
+*              tasks of same priority. It takes effect from the next time slice of the task.
+*
+* Arguments  : pTcb     Task TCB
+*              quanta   Time slice in ticks, 0 for OS_TIME_QUANTA_DFLT
+*
+* Returns    : None
+*
+* Note       : 
+*********************************************************************************************************
+*/
+void OS_Task_SetTimeQuanta(OS_TCB *pTcb, uint32_t quanta) {
+    OS_CPU_SR  cpu_sr = 0u;
+
+    if (quanta == 0U) {
+        quanta = OS_TIME_QUANTA_DFLT;
+    }
+    OS_ENTER_CRITICAL();
+    pTcb->OS_TcbTimeQuanta = quanta;
+    OS_EXIT_CRITICAL();
+}
+
+/*
+*********************************************************************************************************
+*              OS Task Set Deadline
+*
+* Description: This function sets the absolute deadline of a task, in OS_TimeGet() ticks. The ready tasks of
+*              OS_EDF_PRIO run in the order of their deadlines, so a ready task is re-ordered, and preempts
+*              the running one if its deadline is earlier now.
+*
+* Arguments  : pTcb       Task TCB
+*              deadline   Absolute deadline in ticks
+*
+* Returns    : None
+*
+* Note       : The deadline only orders the tasks of OS_EDF_PRIO, it is not enforced.
+*********************************************************************************************************
+*/
+void OS_Task_SetDeadline(OS_TCB *pTcb, uint32_t deadline) {
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    pTcb->OS_TcbDeadline = deadline;
+    if ((OS_EDF_PRIO != 0) && (pTcb->OS_TcbPrio == OS_EDF_PRIO) && (pTcb->OS_TcbState == 0U)) {
+        /* ready, re-insert it at its new deadline */
+        os_utilsRemoveFromListByTaskTcb(pTcb, &ReadyTaskList);
+        os_utilsAddTaskToListByTcb(pTcb, &ReadyTaskList);
+        if (OS_Tcb_Curr != (OS_TCB *)0) { /* not before OS_Run() */
+            OS_sched();
+        }
+    }
+    OS_EXIT_CRITICAL();
+}
+
+/*
+*********************************************************************************************************
+*              OS Task Wait Period
+*
+* Description: This function is called by a periodic task at the end of each job. The deadline of the job
+*              is the release of the next one, so the task is delayed until its deadline, and its new
+*              deadline is one period later. If the deadline is missed, the next job is released at once
+*              with the deadline one period after the missed one, so the task does not drift.
+*
+* Arguments  : period  Period of the task in ticks, must not be 0
+*
+* Returns    : None
+*
+* Note       : Set the first deadline with OS_Task_SetDeadline() before the first job, normally to
+*              OS_TimeGet() + period.
+*********************************************************************************************************
+*/
+void OS_Task_WaitPeriod(uint32_t period) {
+    uint32_t release;
+    uint32_t now;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    Q_REQUIRE(period != 0U);
+    OS_ENTER_CRITICAL();
+    release = OS_Tcb_Curr->OS_TcbDeadline;  /* the next job is released at the deadline of this one */
+    now = OS_TimeGet();
+    if (OS_EDF_BEFORE(now, release)) {
+        OS_Tcb_Curr->OS_TcbDeadline = release + period; /* ordered by it when ready again */
+        OS_Delay(release - now);
+    }
+    else { /* deadline missed, run the next job now */
+        OS_Task_SetDeadline(OS_Tcb_Curr, release + period);
+    }
+    OS_EXIT_CRITICAL();
+}
+
 /*
 *********************************************************************************************************
 *              OS Task Create
@@ -158,51 +305,189 @@ void OS_Task_Create(
 {
     uint32_t *sp;
     uint32_t *stk_limit;
-    uint8_t addStatus;
+    OS_CPU_SR  cpu_sr = 0u;
     
     /* round down the stack top to the 8-byte boundary
     * NOTE: ARM Cortex-M stack grows down from hi -> low memory
     */
-    sp = (uint32_t *)((((uint32_t)stkSto + stkSize) / 8) * 8);
+    sp = (uint32_t *)((((uintptr_t)stkSto + stkSize) / 8) * 8);
+
+    /* round up the bottom of the stack to the 8-byte boundary */
+    stk_limit = (uint32_t *)(((((uintptr_t)stkSto - 1U) / 8) + 1U) * 8);
 
     /* priority must be in range
     * and the priority level must be unused
     */
-    Q_REQUIRE(prio < Q_DIM(ReadyTaskList.TaskList));
-    *(--sp) = (1U << 24);  /* xPSR */
-    *(--sp) = (uint32_t)threadHandler; /* Initailly is threadHandler, later will be PC */
-    /* pre-fill the stack space reserved for registers for easy debug 
-     * the stack space will acutully pushed by register's context when context swithch happens */ 
-    *(--sp) = 0x0000000EU; /* LR  */
-    *(--sp) = 0x0000000CU; /* R12 */
-    *(--sp) = 0x00000003U; /* R3  */
-    *(--sp) = 0x00000002U; /* R2  */
-    *(--sp) = 0x00000001U; /* R1  */
-    *(--sp) = 0x00000000U; /* R0  */
-    /* additionally, fake registers R4-R11 */
-    *(--sp) = 0x0000000BU; /* R11 */
-    *(--sp) = 0x0000000AU; /* R10 */
-    *(--sp) = 0x00000009U; /* R9 */
-    *(--sp) = 0x00000008U; /* R8 */
-    *(--sp) = 0x00000007U; /* R7 */
-    *(--sp) = 0x00000006U; /* R6 */
-    *(--sp) = 0x00000005U; /* R5 */
-    *(--sp) = 0x00000004U; /* R4 */
+    Q_REQUIRE(OS_PRIO_VALID(prio));
+    /* the stack for the stack check, the whole stack includes the initial register frame */
+    myTcb->OS_TcbStkBase = stk_limit;
+    myTcb->OS_TcbStkSize = (uint32_t)(sp - stk_limit);
+
+    /* build the initial register frame, the port knows the layout PendSV_Handler restores */
+    sp = OS_CPU_TaskStkInit(threadHandler, sp, stk_limit);
 
     /* save the top of the stack in the task's attibute */
     myTcb->OS_TcbSp = sp;
 
-    /* round up the bottom of the stack to the 8-byte boundary */
-    stk_limit = (uint32_t *)(((((uint32_t)stkSto - 1U) / 8) + 1U) * 8);
-
-    /* pre-fill the unused part of the stack with 0xDEADBEEF for easy debug */
+    /* pre-fill the unused part of the stack with 0xDEADBEEF for easy debug and the stack check */
     for (sp = sp - 1U; sp >= stk_limit; --sp) {
-        *sp = 0xDEADBEEFU;
+        *sp = OS_STK_FILL;
     }
+    myTcb->OS_TcbStkFree = myTcb->OS_TcbStkSize;
 
     /* register the task with the OS */
     myTcb->OS_TcbPrio = prio;
-    /* make the task ready to run */
-    addStatus = os_utilsAddTaskToReadyListByTcb(myTcb);
-    Q_ASSERT(addStatus == OS_ERR_NONE);
+    myTcb->OS_TcbBasePrio = prio;
+    myTcb->OS_TcbMutexOwned = (OS_EVENT *)0;
+    myTcb->OS_TcbEcbPtr = (OS_EVENT *)0;   /* not waiting on any event */
+    myTcb->OS_TcbState = 0U;
+    myTcb->OS_TcbStatePend = OS_STAT_PEND_OK;
+    myTcb->OS_TcbDlyNext = 0;
+    myTcb->OS_TcbDlyPrev = 0;
+    myTcb->OS_TcbTimeQuanta = OS_TIME_QUANTA_DFLT;
+    myTcb->OS_TcbTimeQuantaCtr = OS_TIME_QUANTA_DFLT;
+    myTcb->OS_TcbDeadline = 0U;
+#if OS_CPU_USAGE_EN != 0
+    myTcb->OS_TcbCpuTime = 0U;
+    myTcb->OS_TcbCpuTimePrev = 0U;
+    myTcb->OS_TcbCpuWin = 0U;
+#endif
+    /* make the task ready to run, the list links are in the TCB, no memory is allocated */
+    OS_ENTER_CRITICAL();
+    myTcb->OS_TcbCreatedNext = os_taskCreatedList;
+    os_taskCreatedList = myTcb;
+    os_utilsAddTaskToListByTcb(myTcb, &ReadyTaskList);
+    OS_EXIT_CRITICAL();
+}
+
+/*
+*********************************************************************************************************
+*              OS Task Stack Check
+*
+* Description: This function scans the stack of a task for its stack usage. The fill of OS_Task_Create()
+*              is counted from the bottom of the stack up to the first word the task has written, which is
+*              the deepest the stack has been used since the task was created. The result is also kept in
+*              the TCB, where the background scan of the idle task updates it too.
+*
+* Arguments  : pTcb    the task to check, or 0 for the idle task
+*              pData   where the stack usage is copied
+*
+* Returns    : OS_ERR_NONE
+*
+* Note       : The scan is not in a critical section, the cost is one read for each word never used. A
+*              value written by the task equal to OS_STK_FILL at the boundary would be counted as free.
+*********************************************************************************************************
+*/
+uint8_t OS_Task_StkChk(OS_TCB *pTcb, OS_STK_DATA *pData) {
+    uint32_t *pStk;
+    uint32_t *pEnd;
+    uint32_t freeWords;
+
+    Q_REQUIRE(pData != (OS_STK_DATA *)0);
+    if (pTcb == (OS_TCB *)0) {
+        pTcb = &idleTask;
+    }
+    pStk = pTcb->OS_TcbStkBase;
+    pEnd = pStk + pTcb->OS_TcbStkSize;
+    while ((pStk < pEnd) && (*pStk == OS_STK_FILL)) {
+        pStk++;
+    }
+    os_taskStkFreeSet(pTcb, (uint32_t)(pStk - pTcb->OS_TcbStkBase));
+
+    freeWords = pTcb->OS_TcbStkFree;
+    pData->OS_StkSize = pTcb->OS_TcbStkSize * sizeof(uint32_t);
+    pData->OS_StkFree = freeWords * sizeof(uint32_t);
+    pData->OS_StkUsed = (pTcb->OS_TcbStkSize - freeWords) * sizeof(uint32_t);
+    return (OS_ERR_NONE);
+}
+
+/*
+*********************************************************************************************************
+*              OS Task Get Next
+*
+* Description: This function walks through all the tasks created, including the idle task and the timer
+*              task, for a report of the stack usage of all the tasks.
+*
+* Arguments  : pTcb    a task, or 0 to get the first task
+*
+* Returns    : the task after pTcb, or 0 after the last task
+*
+* Note       : Tasks are never deleted, so the list is only added to, at its head.
+*********************************************************************************************************
+*/
+OS_TCB *OS_Task_GetNext(OS_TCB *pTcb) {
+    return (pTcb == (OS_TCB *)0) ? os_taskCreatedList : pTcb->OS_TcbCreatedNext;
+}
+
+/*
+*********************************************************************************************************
+*              Record the free stack of a task
+*
+* Description: This function keeps the least free stack seen in OS_TcbStkFree. The free stack of a task
+*              only goes down, a scan may see more free stack if it read a word before the task wrote it.
+*
+* Arguments  : pTcb    the task
+*              freeWords  free stack found by a scan, in 32-bit words
+*
+* Returns    : None
+*********************************************************************************************************
+*/
+static void os_taskStkFreeSet(OS_TCB *pTcb, uint32_t freeWords) {
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    if (freeWords < pTcb->OS_TcbStkFree) {
+        pTcb->OS_TcbStkFree = freeWords;
+    }
+    OS_EXIT_CRITICAL();
+}
+
+#if OS_STK_SCAN_WORDS != 0
+/*
+*********************************************************************************************************
+*              Background stack scan
+*
+* Description: This function is called by the idle task to scan the stacks a part at a time. Each call
+*              scans at most OS_STK_SCAN_WORDS words of the stack of a task, from where the last call
+*              stopped. When the fill ends, the free stack of the task is recorded and the scan goes to the
+*              next task, and after the last task it starts again with the first one. So the cost of the
+*              stack check is spread over the idle time, and OS_TcbStkFree of every task is kept current.
+*
+* Arguments  : None
+*
+* Returns    : None
+*
+* Note       : Only the idle task uses the scan state, so it needs no critical section.
+*********************************************************************************************************
+*/
+static void os_taskStkScan(void) {
+    OS_TCB *pTcb;
+    uint32_t *pStk;
+    uint32_t *pEnd;
+    uint32_t n;
+
+    pTcb = os_stkScanTcb;
+    if (pTcb == (OS_TCB *)0) {
+        pTcb = os_taskCreatedList;
+        os_stkScanPtr = pTcb->OS_TcbStkBase;
+    }
+    pStk = os_stkScanPtr;
+    pEnd = pTcb->OS_TcbStkBase + pTcb->OS_TcbStkSize;
+    for (n = OS_STK_SCAN_WORDS; n != 0U; n--) {
+        if ((pStk >= pEnd) || (*pStk != OS_STK_FILL)) {
+            break;
+        }
+        pStk++;
+    }
+    if (n == 0U) {                          /* not at the end of the fill yet, continue next time */
+        os_stkScanTcb = pTcb;
+        os_stkScanPtr = pStk;
+        return;
+    }
+    os_taskStkFreeSet(pTcb, (uint32_t)(pStk - pTcb->OS_TcbStkBase));
+    os_stkScanTcb = pTcb->OS_TcbCreatedNext;
+    if (os_stkScanTcb != (OS_TCB *)0) {
+        os_stkScanPtr = os_stkScanTcb->OS_TcbStkBase;
+    }
 }
+#endif
@@ -0,0 +1,446 @@
+/****************************************************************************
+* Mini Real-time Operating System (MiniRTOS)
+* version 1.0 2025
+*
+* This software is to illustrate the concepts of Real-Time Operating System (RTOS).
+* This MiniRTOS program is designed to use Array and Bit Map to implement Task List
+* to speed up task search time. Therefore, the task priority is limited 0-31. It allows
+* same priority has more than one tasks. The same priority tasks are arranged with link list.
+* For most applications, few tasks need at same priority. Therefore the same priority task
+* link list should be short, and its search time and variant should be acceptable.
+*
+* This program is under the terms of the GNU General Public License as published by
+* the Free Software Foundation. This program does not have ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See GNU General Public License <https://www.gnu.org/licenses/> for more details.
+*
+* Git repo:
+*
+****************************************************************************/
+#include "os_utils_event.h"
+#include "os.h"
+#include "os_sched.h"
+#include "os_tmr.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_FILE
+
+OS_TMR *OSTmrFreeList;                /* Pointer to list of free TIMER control blocks */
+OS_TMR OSTmrTbl[OS_MAX_TMRS];         /* Table of TIMER control blocks */
+
+static OS_TMR   *OSTmrListHead;       /* First running timer, the one to expire first */
+static uint32_t OSTmrTicksPending;    /* Ticks passed but not applied to the running timers yet */
+static uint8_t  OSTmrSignaled;        /* Timer task is signaled and has not started processing */
+static OS_EVENT *OSTmrSem;            /* Signals the timer task when a timer expires */
+
+OS_TCB OSTmrTaskTcb;
+static uint32_t OSTmrTaskStk[OS_TMR_TASK_STK_SIZE];
+
+static void os_tmrTask(void);
+static void os_tmrInsert(OS_TMR *pTmr, uint32_t ticks);
+static void os_tmrUnlink(OS_TMR *pTmr);
+
+/*
+*********************************************************************************************************
+*               TIMER MODULE INITIALIZATION
+*
+* Description : This function is called by OS_Init() to initialize the free list of timers, and to create
+*               the timer task and its semaphore.
+*
+* Arguments   : none
+*
+* Returns     : none
+*
+* Note(s)    : This function is INTERNAL to OS and your application should not call it.
+*********************************************************************************************************
+*/
+void OS_Tmr_Init(void)
+{
+    uint16_t index;
+
+    OS_MemClr((uint8_t *)&OSTmrTbl[0], sizeof(OSTmrTbl));   /* Clear the timer table                   */
+    for (index = 0u; index < (OS_MAX_TMRS - 1u); index++) {  /* Init. list of free TIMER control blocks */
+        OSTmrTbl[index].OS_TmrNext  = &OSTmrTbl[index + 1u];
+        OSTmrTbl[index].OS_TmrState = OS_TMR_STATE_UNUSED;
+        OSTmrTbl[index].OS_TmrName  = "?";
+    }
+    OSTmrTbl[index].OS_TmrNext  = (OS_TMR *)0;
+    OSTmrTbl[index].OS_TmrState = OS_TMR_STATE_UNUSED;
+    OSTmrTbl[index].OS_TmrName  = "?";
+    OSTmrFreeList     = &OSTmrTbl[0];
+    OSTmrListHead     = (OS_TMR *)0;
+    OSTmrTicksPending = 0u;
+    OSTmrSignaled     = 0u;
+
+    OSTmrSem = OS_Sem_Create(0u, "tmr");
+    Q_ASSERT(OSTmrSem != (OS_EVENT *)0);
+    OS_Task_Create(&OSTmrTaskTcb,
+                   OS_TMR_TASK_PRIO,
+                   &os_tmrTask,
+                   OSTmrTaskStk, sizeof(OSTmrTaskStk));
+}
+/*
+*********************************************************************************************************
+*               CREATE A TIMER
+*
+* Description: This function creates a timer. The timer is not running until OS_Tmr_Start() is called.
+*              The callback is called by the timer task, not in the tick interrupt, so it can call any OS
+*              service, but it should not block because it delays all other timers.
+*
+* Arguments  : dly       is the ticks to the first expiry after the timer is started. For a periodic timer
+*                        0 means the first expiry is after 'period'.
+*
+*              period    is the ticks between expiries of a periodic timer, not used by a one shot timer.
+*
+*              opt       OS_TMR_OPT_ONE_SHOT  the timer stops after it expires
+*                        OS_TMR_OPT_PERIODIC  the timer restarts with 'period' after it expires
+*
+*              callback  is the function called when the timer expires, may be 0.
+*
+*              pArg      is the argument passed to the callback.
+*
+*              name      is the name of the timer.
+*
+*              perr      is a pointer to where an error message will be deposited:
+*
+*                        OS_ERR_NONE           The timer is created.
+*                        OS_ERR_TMR_INVALID    'opt', 'dly' or 'period' is not valid.
+*                        OS_ERR_OTHER          No free timer.
+*
+* Returns    : != (OS_TMR *)0  is a pointer to the created timer
+*              == (OS_TMR *)0  if the timer is not created
+*********************************************************************************************************
+*/
+OS_TMR *OS_Tmr_Create(uint32_t         dly,
+                      uint32_t         period,
+                      uint8_t          opt,
+                      OS_TMR_CALLBACK  callback,
+                      void             *pArg,
+                      char             *name,
+                      uint8_t          *pErr)
+{
+    OS_TMR     *pTmr;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    if (((opt == OS_TMR_OPT_ONE_SHOT) && (dly == 0u)) ||
+        ((opt == OS_TMR_OPT_PERIODIC) && (period == 0u)) ||
+        ((opt != OS_TMR_OPT_ONE_SHOT) && (opt != OS_TMR_OPT_PERIODIC))) {
+        *pErr = OS_ERR_TMR_INVALID;
+        return ((OS_TMR *)0);
+    }
+    OS_ENTER_CRITICAL();
+    pTmr = OSTmrFreeList;                          /* Get next free timer control block */
+    if (OSTmrFreeList != (OS_TMR *)0) {
+        OSTmrFreeList = OSTmrFreeList->OS_TmrNext;
+    }
+    OS_EXIT_CRITICAL();
+    if (pTmr == (OS_TMR *)0) {
+        *pErr = OS_ERR_OTHER;
+        return ((OS_TMR *)0);
+    }
+    pTmr->OS_TmrNext        = (OS_TMR *)0;
+    pTmr->OS_TmrPrev        = (OS_TMR *)0;
+    pTmr->OS_TmrTimeout     = 0u;
+    pTmr->OS_TmrDly         = dly;
+    pTmr->OS_TmrPeriod      = period;
+    pTmr->OS_TmrCallback    = callback;
+    pTmr->OS_TmrCallbackArg = pArg;
+    pTmr->OS_TmrOpt         = opt;
+    pTmr->OS_TmrName        = name;
+    pTmr->OS_TmrState       = OS_TMR_STATE_STOPPED;
+    *pErr = OS_ERR_NONE;
+    return (pTmr);
+}
+/*
+*********************************************************************************************************
+*               START A TIMER
+*
+* Description: This function starts a timer, or restarts a running timer from now.
+*
+* Arguments  : pTmr      is a pointer to the timer.
+*
+* Returns    : OS_ERR_NONE           The timer is started.
+*              OS_ERR_TMR_INVALID    'pTmr' is not a created timer.
+*********************************************************************************************************
+*/
+uint8_t OS_Tmr_Start(OS_TMR *pTmr)
+{
+    uint32_t   ticks;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    if (pTmr->OS_TmrState == OS_TMR_STATE_UNUSED) {
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_TMR_INVALID);
+    }
+    if (pTmr->OS_TmrState == OS_TMR_STATE_RUNNING) {
+        os_tmrUnlink(pTmr);
+    }
+    ticks = (pTmr->OS_TmrDly != 0u) ? pTmr->OS_TmrDly : pTmr->OS_TmrPeriod;
+    if (OSTmrListHead == (OS_TMR *)0) {               /* No running timer, no ticks pending to apply */
+        OSTmrTicksPending = 0u;
+    }
+    os_tmrInsert(pTmr, ticks + OSTmrTicksPending);   /* The list is behind by the pending ticks     */
+    pTmr->OS_TmrState = OS_TMR_STATE_RUNNING;
+    OS_EXIT_CRITICAL();
+    return (OS_ERR_NONE);
+}
+/*
+*********************************************************************************************************
+*               STOP A TIMER
+*
+* Description: This function stops a running timer. Its callback is not called.
+*
+* Arguments  : pTmr      is a pointer to the timer.
+*
+* Returns    : OS_ERR_NONE           The timer is stopped.
+*              OS_ERR_TMR_INACTIVE   The timer is not running.
+*              OS_ERR_TMR_INVALID    'pTmr' is not a created timer.
+*********************************************************************************************************
+*/
+uint8_t OS_Tmr_Stop(OS_TMR *pTmr)
+{
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    if (pTmr->OS_TmrState == OS_TMR_STATE_UNUSED) {
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_TMR_INVALID);
+    }
+    if (pTmr->OS_TmrState != OS_TMR_STATE_RUNNING) {
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_TMR_INACTIVE);
+    }
+    os_tmrUnlink(pTmr);
+    pTmr->OS_TmrState = OS_TMR_STATE_STOPPED;
+    OS_EXIT_CRITICAL();
+    return (OS_ERR_NONE);
+}
+/*
+*********************************************************************************************************
+*               DELETE A TIMER
+*
+* Description: This function stops a timer if it is running, and returns it to the free list.
+*
+* Arguments  : pTmr      is a pointer to the timer.
+*
+* Returns    : OS_ERR_NONE           The timer is deleted.
+*              OS_ERR_TMR_INVALID    'pTmr' is not a created timer.
+*********************************************************************************************************
+*/
+uint8_t OS_Tmr_Delete(OS_TMR *pTmr)
+{
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    if (pTmr->OS_TmrState == OS_TMR_STATE_UNUSED) {
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_TMR_INVALID);
+    }
+    if (pTmr->OS_TmrState == OS_TMR_STATE_RUNNING) {
+        os_tmrUnlink(pTmr);
+    }
+    pTmr->OS_TmrState = OS_TMR_STATE_UNUSED;
+    pTmr->OS_TmrName  = "?";
+    pTmr->OS_TmrNext  = OSTmrFreeList;               /* Return timer to free list */
+    OSTmrFreeList     = pTmr;
+    OS_EXIT_CRITICAL();
+    return (OS_ERR_NONE);
+}
+/*
+*********************************************************************************************************
+*               TIMER TICK
+*
+* Description: This function is called by OS_tickAdvance() with the ticks passed. It only counts the ticks
+*              and checks the first running timer, so the cost does not depend on the number of timers.
+*              When the first timer is due, the timer task is signaled, and the timer task applies the
+*              pending ticks to the running timers.
+*
+* Arguments  : ticks     number of ticks passed
+*
+* Returns    : none
+*
+* Note(s)    : This function is INTERNAL to OS and your application should not call it. It is called with
+*              interrupts disabled.
+*********************************************************************************************************
+*/
+void OS_TmrTick(uint32_t ticks)
+{
+    if (OSTmrListHead == (OS_TMR *)0) {              /* No running timer */
+        OSTmrTicksPending = 0u;
+        return;
+    }
+    OSTmrTicksPending += ticks;
+    if ((OSTmrSignaled == 0u) && (OSTmrListHead->OS_TmrTimeout <= OSTmrTicksPending)) {
+        OSTmrSignaled = 1u;
+        (void)OS_Sem_Post(OSTmrSem);
+    }
+}
+/*
+*********************************************************************************************************
+*               TIMER NEXT TIMEOUT
+*
+* Description: This function returns the ticks to the first timer expiry, for the tickless idle.
+*
+* Arguments  : none
+*
+* Returns    : ticks to the first timer expiry, or NO_TIMEOUT if no timer is running
+*
+* Note(s)    : This function is INTERNAL to OS and your application should not call it. It is called with
+*              interrupts disabled.
+*********************************************************************************************************
+*/
+uint32_t OS_TmrNextTimeout(void)
+{
+    if (OSTmrListHead == (OS_TMR *)0) {
+        return NO_TIMEOUT;
+    }
+    if (OSTmrListHead->OS_TmrTimeout <= OSTmrTicksPending) {
+        return 0u;
+    }
+    return (OSTmrListHead->OS_TmrTimeout - OSTmrTicksPending);
+}
+/*
+*********************************************************************************************************
+*               PROCESS EXPIRED TIMERS
+*
+* Description: This function is called by the timer task when it is signaled. It applies the pending ticks
+*              to the running timers, and calls the callbacks of all the expired timers in one batch. A
+*              timer is removed from the list with interrupts disabled, and its callback is called with
+*              interrupts enabled. A periodic timer is put back with its period counted from the tick it
+*              expired, so it does not drift when the timer task runs late.
+*
+* Arguments  : none
+*
+* Returns    : none
+*
+* Note(s)    : This function is INTERNAL to OS and your application should not call it.
+*********************************************************************************************************
+*/
+void OS_TmrProcess(void)
+{
+    OS_TMR           *pTmr;
+    OS_TMR_CALLBACK  callback;
+    void             *pArg;
+    OS_CPU_SR        cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    OSTmrSignaled = 0u;
+    OS_EXIT_CRITICAL();
+    for (;;) {
+        OS_ENTER_CRITICAL();
+        pTmr = OSTmrListHead;
+        if ((pTmr == (OS_TMR *)0) || (pTmr->OS_TmrTimeout > OSTmrTicksPending)) {
+            OS_EXIT_CRITICAL();
+            break;                                    /* No more expired timer */
+        }
+        OSTmrTicksPending -= pTmr->OS_TmrTimeout;    /* The list is at the expiry of this timer now */
+        pTmr->OS_TmrTimeout = 0u;
+        os_tmrUnlink(pTmr);
+        if (pTmr->OS_TmrOpt == OS_TMR_OPT_PERIODIC) {
+            os_tmrInsert(pTmr, pTmr->OS_TmrPeriod);
+        }
+        else {
+            pTmr->OS_TmrState = OS_TMR_STATE_STOPPED;
+        }
+        callback = pTmr->OS_TmrCallback;
+        pArg     = pTmr->OS_TmrCallbackArg;
+        OS_EXIT_CRITICAL();
+        if (callback != (OS_TMR_CALLBACK)0) {
+            callback(pTmr, pArg);
+        }
+    }
+}
+/*
+*********************************************************************************************************
+*               TIMER TASK
+*
+* Description: This function is the timer task. It waits to be signaled by OS_TmrTick(), and processes the
+*              expired timers.
+*
+* Arguments  : none
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+static void os_tmrTask(void)
+{
+    uint8_t err;
+
+    while (1) {
+        OS_Sem_Wait(OSTmrSem, 0u, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        OS_TmrProcess();
+    }
+}
+/*
+*********************************************************************************************************
+*               INSERT A TIMER TO THE RUNNING TIMER LIST
+*
+* Description: This function inserts a timer to the running timer delta list by its expiry. Timers expire
+*              at same tick are in the order they are inserted.
+*
+* Arguments  : pTmr      is a pointer to the timer.
+*
+*              ticks     is the ticks to expire, relative to the tick the list is at.
+*
+* Returns    : none
+*
+* Note(s)    : It is called with interrupts disabled.
+*********************************************************************************************************
+*/
+static void os_tmrInsert(OS_TMR *pTmr, uint32_t ticks)
+{
+    OS_TMR *pWalk;
+    OS_TMR *pPrev;
+
+    pPrev = (OS_TMR *)0;
+    pWalk = OSTmrListHead;
+    while ((pWalk != (OS_TMR *)0) && (pWalk->OS_TmrTimeout <= ticks)) {
+        ticks -= pWalk->OS_TmrTimeout;               /* make it relative to the walked timer */
+        pPrev = pWalk;
+        pWalk = pWalk->OS_TmrNext;
+    }
+    pTmr->OS_TmrTimeout = ticks;
+    pTmr->OS_TmrPrev    = pPrev;
+    pTmr->OS_TmrNext    = pWalk;
+    if (pWalk != (OS_TMR *)0) {                      /* the walked timer is relative to this one now */
+        pWalk->OS_TmrTimeout -= ticks;
+        pWalk->OS_TmrPrev = pTmr;
+    }
+    if (pPrev == (OS_TMR *)0) {
+        OSTmrListHead = pTmr;
+    }
+    else {
+        pPrev->OS_TmrNext = pTmr;
+    }
+}
+/*
+*********************************************************************************************************
+*               UNLINK A TIMER FROM THE RUNNING TIMER LIST
+*
+* Description: This function removes a timer from the running timer delta list. Its ticks left are added
+*              to the timer after it, so the expiry of the timer after it is not changed.
+*
+* Arguments  : pTmr      is a pointer to the timer, it must be running.
+*
+* Returns    : none
+*
+* Note(s)    : It is called with interrupts disabled.
+*********************************************************************************************************
+*/
+static void os_tmrUnlink(OS_TMR *pTmr)
+{
+    if (pTmr->OS_TmrNext != (OS_TMR *)0) {
+        pTmr->OS_TmrNext->OS_TmrTimeout += pTmr->OS_TmrTimeout;
+        pTmr->OS_TmrNext->OS_TmrPrev = pTmr->OS_TmrPrev;
+    }
+    if (pTmr->OS_TmrPrev == (OS_TMR *)0) {           /* it is the first one */
+        OSTmrListHead = pTmr->OS_TmrNext;
+    }
+    else {
+        pTmr->OS_TmrPrev->OS_TmrNext = pTmr->OS_TmrNext;
+    }
+    pTmr->OS_TmrNext = (OS_TMR *)0;
+    pTmr->OS_TmrPrev = (OS_TMR *)0;
+}
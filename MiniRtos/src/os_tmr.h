@@ -0,0 +1,10 @@
+#ifndef __OS_TMR_H__
+#define __OS_TMR_H__
+#include "os.h"
+
+void OS_Tmr_Init(void);
+void OS_TmrTick(uint32_t ticks);
+uint32_t OS_TmrNextTimeout(void);
+void OS_TmrProcess(void);
+
+#endif /* __OS_TMR_H__ */
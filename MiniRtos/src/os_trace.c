@@ -0,0 +1,163 @@
+/****************************************************************************
+* Mini Real-time Operating System (MiniRTOS)
+* version 1.0 2025
+*
+* This software is to illustrate the concepts of Real-Time Operating System (RTOS).
+* This MiniRTOS program is designed to use Array and Bit Map to implement Task List
+* to speed up task search time. Therefore, the task priority is limited 0-31. It allows
+* same priority has more than one tasks. The same priority tasks are arranged with link list.
+* For most applications, few tasks need at same priority. Therefore the same priority task
+* link list should be short, and its search time and variant should be acceptable.
+*
+* This program is under the terms of the GNU General Public License as published by
+* the Free Software Foundation. This program does not have ANY WARRANTY; without even
+* the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See GNU General Public License <https://www.gnu.org/licenses/> for more details.
+*
+* Git repo:
+*
+****************************************************************************/
+
+#include <stdint.h>
+#include "os.h"
+
+#if OS_TRACE_EN != 0
+
+#if (OS_TRACE_SIZE == 0) || ((OS_TRACE_SIZE & (OS_TRACE_SIZE - 1)) != 0)
+#error "OS_TRACE_SIZE must be a power of 2, the ring index is masked with OS_TRACE_SIZE - 1"
+#endif
+
+#define OS_TRACE_MAGIC        0x4352544Du     /* "MTRC" */
+#define OS_TRACE_VERSION      1u
+#define OS_TRACE_PRIO_NONE    0xFFu
+
+typedef struct os_trace_hdr {          /* HEADER OF A DUMP, read by Tools/os_trace_decode.py */
+    uint32_t         OS_TraceMagic;
+    uint8_t          OS_TraceVersion;
+    uint8_t          OS_TraceRecSize;  /* sizeof(OS_TRACE_REC) */
+    uint8_t          OS_TraceArg1Size; /* sizeof(uintptr_t) */
+    uint8_t          OS_TraceRsvd;
+    uint32_t         OS_TraceCnt;      /* Records in the dump */
+    uint32_t         OS_TraceSeq;      /* Sequence number of the first record, records before are lost */
+} OS_TRACE_HDR;
+
+extern OS_TCB * volatile OS_Tcb_Curr;
+
+static OS_TRACE_REC os_traceBuf[OS_TRACE_SIZE];
+static uint32_t os_traceIdx;           /* Records written, free running, the next one is at the index */
+static volatile uint8_t os_traceOn = 1u;
+
+/*
+*********************************************************************************************************
+*              RECORD A TRACE EVENT
+*
+* Description: This function writes a record to the trace ring. A slot is taken by an atomic increment
+*              of the index, so tasks and interrupts record without a critical section, and an interrupt
+*              recording in the middle of a record takes the next slot. When the ring is full, the oldest
+*              record is overwritten.
+*
+* Arguments  : event     is OS_TRACE_EV_xxx.
+*
+*              arg0      arg1   are the arguments of the event.
+*
+* Returns    : none
+* Note(s)    : Use OS_TRACE(), which compiles out when OS_TRACE_EN is 0.
+*********************************************************************************************************
+*/
+void OS_Trace_Rec(uint8_t event, uint16_t arg0, uintptr_t arg1)
+{
+    OS_TRACE_REC *pRec;
+    OS_TCB *pTcb;
+
+    if (os_traceOn == 0u) {
+        return;
+    }
+    pRec = &os_traceBuf[__atomic_fetch_add(&os_traceIdx, 1u, __ATOMIC_RELAXED) & (OS_TRACE_SIZE - 1u)];
+    pTcb = OS_Tcb_Curr;
+    pRec->OS_TraceTs    = OS_CPU_TS_GET();
+    pRec->OS_TraceEvent = event;
+    pRec->OS_TracePrio  = (pTcb != (OS_TCB *)0) ? pTcb->OS_TcbPrio : OS_TRACE_PRIO_NONE;
+    pRec->OS_TraceArg0  = arg0;
+    pRec->OS_TraceArg1  = arg1;
+}
+
+/*
+*********************************************************************************************************
+*              START AND STOP THE TRACE
+*
+* Description: OS_Trace_Stop() stops recording, so the ring keeps the records before a point of interest,
+*              an assertion for example. OS_Trace_Start() empties the ring and records again. Recording
+*              is on after reset.
+*
+* Arguments  : none
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+void OS_Trace_Start(void)
+{
+    OS_CPU_SR  cpu_sr = 0u;
+
+    OS_ENTER_CRITICAL();
+    os_traceIdx = 0u;
+    os_traceOn  = 1u;
+    OS_EXIT_CRITICAL();
+}
+
+void OS_Trace_Stop(void)
+{
+    os_traceOn = 0u;
+}
+
+/*
+*********************************************************************************************************
+*              DUMP THE TRACE
+*
+* Description: This function stops recording and writes the ring, oldest record first, for the host
+*              decoder Tools/os_trace_decode.py. The dump is a header, the records as they are in memory,
+*              and for each OS_TRACE_EV_STR record in order, the length of its string in 2 bytes and the
+*              string. All in the byte order of the CPU.
+*
+* Arguments  : write     is the function writing the dump, to a UART or a file. It is called a few bytes
+*                        at a time.
+*
+* Returns    : none
+* Note(s)    : The strings of OS_TRACE_EV_STR are read now, so they must be constant.
+*********************************************************************************************************
+*/
+void OS_Trace_Dump(void (*write)(void const *pData, uint32_t len))
+{
+    OS_TRACE_HDR hdr;
+    OS_TRACE_REC *pRec;
+    char const *pStr;
+    uint32_t i;
+    uint16_t len;
+
+    OS_Trace_Stop();
+    hdr.OS_TraceMagic    = OS_TRACE_MAGIC;
+    hdr.OS_TraceVersion  = OS_TRACE_VERSION;
+    hdr.OS_TraceRecSize  = (uint8_t)sizeof(OS_TRACE_REC);
+    hdr.OS_TraceArg1Size = (uint8_t)sizeof(uintptr_t);
+    hdr.OS_TraceRsvd     = 0u;
+    hdr.OS_TraceCnt      = (os_traceIdx < OS_TRACE_SIZE) ? os_traceIdx : OS_TRACE_SIZE;
+    hdr.OS_TraceSeq      = os_traceIdx - hdr.OS_TraceCnt;
+    write(&hdr, sizeof(hdr));
+
+    for (i = hdr.OS_TraceSeq; i != os_traceIdx; i++) {
+        write(&os_traceBuf[i & (OS_TRACE_SIZE - 1u)], sizeof(OS_TRACE_REC));
+    }
+    for (i = hdr.OS_TraceSeq; i != os_traceIdx; i++) {
+        pRec = &os_traceBuf[i & (OS_TRACE_SIZE - 1u)];
+        if (pRec->OS_TraceEvent == OS_TRACE_EV_STR) {
+            pStr = (char const *)pRec->OS_TraceArg1;
+            for (len = 0u; (pStr != (char const *)0) && (pStr[len] != '\0') && (len < 0xFFFFu); len++) {
+            }
+            write(&len, sizeof(len));
+            if (len != 0u) {
+                write(pStr, len);
+            }
+        }
+    }
+}
+
+#endif /* OS_TRACE_EN */
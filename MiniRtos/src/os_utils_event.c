@@ -22,6 +22,7 @@
 #include "os.h"
 #include <stdint.h>
 #include "os_utils_list.h"
+#include "os_mutex.h"
 #include "qassert.h"
 
 Q_DEFINE_THIS_FILE
@@ -69,22 +70,44 @@ void OS_InitEventList(void)
     OSEventFreeList         = &OSEventTbl[0];
 }
 
+/*
+*********************************************************************************************************
+*              INITIALIZE EVENT WAIT LIST
+*
+* Description: This function is called when an event is created, to initialize its wait list to
+*              'nobody waiting'.
+*
+* Arguments  : pEvent   is a pointer to the event control block
+*
+* Returns    : None
+*
+* Note       : This function is INTERNAL to OS and your application should not call it.
+*********************************************************************************************************
+*/
 void OS_EventWaitListInit(OS_EVENT *pEvent)
 {
     int i;
     /* No task waiting on event */
     for(i=0;i<MAX_TASKS_IN_LIST;i++){
-        WaitingTaskList.TaskList[i] = 0;
+        pEvent->OS_EventWaitList.TaskList[i] = 0;
+    }
+    for(i=0;i<PRIORITY_GROUPS;i++){
+        pEvent->OS_EventWaitList.TaskRriorityBitMap[i] = 0;
     }
+    pEvent->OS_EventWaitList.TaskGroupBitMap = 0;
 }
 
 /*
 *********************************************************************************************************
 *              MAKE TASK WAIT FOR EVENT TO OCCUR
 *
-* Description: This function is called by other services to suspend a task to wait for an event.
+* Description: This function is called by other services to suspend a task to wait for an event. The task
+*              is moved from ReadyTaskList to the wait list of the event in its OS_TcbEcbPtr. If the task
+*              waits with timeout, it is also added to DelayedTaskList, so OS_tick() readies it when the
+*              timeout expires.
 *
 * Arguments  : tcb_curr   is a pointer to current task control block for which the task will be waiting for.
+*                         Its OS_TcbTimeout is the ticks to wait, 0 or NO_TIMEOUT to wait forever.
 *
 * Returns    : None
 *
@@ -93,11 +116,45 @@ void OS_EventWaitListInit(OS_EVENT *pEvent)
 */
 void OS_EventTaskWait(OS_TCB *tcb_curr)
 {   
-    Task_List_Node *taskListNode;
     
-    taskListNode = os_utilsRemoveFromListByTaskTcb(tcb_curr,READY_TASK_LIST);
-    Q_ASSERT(taskListNode);
-    os_utilsAddTaskToListByNode(taskListNode, WAITING_TASK_LIST);
+    Q_ASSERT(tcb_curr->OS_TcbEcbPtr);
+    OS_TRACE(OS_TRACE_EV_BLOCK, tcb_curr->OS_TcbState, tcb_curr->OS_TcbEcbPtr);
+    os_utilsRemoveFromListByTaskTcb(tcb_curr, &ReadyTaskList);
+    os_utilsAddTaskToListByTcb(tcb_curr, &tcb_curr->OS_TcbEcbPtr->OS_EventWaitList);
+    if ((tcb_curr->OS_TcbTimeout != 0U) && (tcb_curr->OS_TcbTimeout != NO_TIMEOUT)) {
+        os_utilsAddTaskToDelayedListByTcb(tcb_curr);
+    }
+}
+
+/*
+*********************************************************************************************************
+*              REMOVE TASK FROM EVENT WAIT LIST
+*
+* Description: This function is called by OS_tick() when a task waiting for an event timeout. The task is
+*              removed from the wait list of the event it waits for, and its pending state is cleared. The
+*              task is already removed from DelayedTaskList by the caller. If the event is a mutex, the
+*              owner no longer inherits the priority of the task, so its priority is updated at once.
+*
+* Arguments  : pTcb       is a pointer to the task control block of the timeout task.
+*
+* Returns    : None
+*
+* Note       : This function is INTERNAL to OS and your application should not call it.
+*********************************************************************************************************
+*/
+void OS_EventTaskRemove(OS_TCB *pTcb)
+{
+    OS_EVENT *pEvent;
+
+    pEvent = pTcb->OS_TcbEcbPtr;
+    Q_ASSERT(pEvent);
+    os_utilsRemoveFromListByTaskTcb(pTcb, &pEvent->OS_EventWaitList);
+    pTcb->OS_TcbEcbPtr     = (OS_EVENT *)0;
+    pTcb->OS_TcbState     &= ~OS_STAT_PEND_ANY;
+    pTcb->OS_TcbStatePend  = OS_STAT_PEND_TO;
+    if (pEvent->OS_EventType == OS_EVENT_TYPE_MUTEX) { /* a waiter has an owner */
+        OS_MutexPrioUpdate((OS_TCB *)pEvent->OS_EventPtr);
+    }
 }
 
 /*
@@ -106,7 +163,9 @@ void OS_EventTaskWait(OS_TCB *tcb_curr)
 *
 * Description: This function is called by other services and is used to move a task that was
 *              waiting for the event from waiting list to ready list. This function finds the highiest 
-               priority task in the waiting list matched the waiting event and return it.
+               priority task in the wait list of the event and return it. If the task waits with timeout,
+*              it is removed from DelayedTaskList too. The message is given to the task in its
+*              OS_TcbMQMsg.
 *
 * Arguments  : pevent      is a pointer to the event control block corresponding to the event.
 *
@@ -133,18 +192,55 @@ uint8_t OS_EventTaskReady(OS_EVENT  *pEvent,
                           uint8_t   msk,
                           uint8_t   pend_state)
 {
-    Task_List_Node *pTaskListNode;
+    OS_TCB *pTcb;
+    Task_List *pWaitList;
 
-    msk = msk;
-    pMsg = pMsg;
-    
-    pTaskListNode = os_utilsRemoveFromWaitingListHPT(pEvent);
-    if(pTaskListNode){
-        os_utilsAddTaskToListByNode(pTaskListNode, READY_TASK_LIST);
-        return OS_TASK_PENDING;
-    }
-    else 
+    pWaitList = &pEvent->OS_EventWaitList;
+    if (pWaitList->TaskGroupBitMap == 0U) { /* no task waiting */
         return OS_NO_TASK_PENDING;
+    }
+    pTcb = pWaitList->TaskList[os_utilsGetHighestPriority(pWaitList)];
+    pTcb->OS_TcbMQMsg = pMsg;                /* Message handed to the task directly */
+    OS_EventTaskReadyByTcb(pTcb, msk, pend_state);
+    return OS_TASK_PENDING;
+}
+
+/*
+*********************************************************************************************************
+*              MAKE A WAITING TASK READY TO RUN
+*
+* Description: This function moves a specified task waiting for an event from the wait list of the event
+*              to ready list. If the task waits with timeout, it is removed from DelayedTaskList too.
+*              Services which may ready more than one task for an event, like event flags, use it.
+*
+* Arguments  : pTcb        is a pointer to the task control block of the task to ready, it must wait
+*                          on the event in its OS_TcbEcbPtr.
+*
+*              msk         is a mask that is used to clear the status byte of the TCB.
+*
+*              pend_stat   is used to indicate the readied task's pending status.
+*
+* Returns    : none
+*
+* Note       : This function is INTERNAL to OS and your application should not call it.
+*********************************************************************************************************
+*/
+void OS_EventTaskReadyByTcb(OS_TCB *pTcb, uint8_t msk, uint8_t pend_state)
+{
+    OS_CPU_SR  cpu_sr = 0u;
+
+    Q_ASSERT(pTcb->OS_TcbEcbPtr);
+    OS_ENTER_CRITICAL();
+    os_utilsRemoveFromListByTaskTcb(pTcb, &pTcb->OS_TcbEcbPtr->OS_EventWaitList);
+    if ((pTcb->OS_TcbState & OS_STAT_DLY) != 0U) { /* waits with timeout */
+        os_utilsRemoveFromDelayedListByTcb(pTcb);
+    }
+    pTcb->OS_TcbEcbPtr     = (OS_EVENT *)0;
+    pTcb->OS_TcbState     &= (uint8_t)~msk;
+    pTcb->OS_TcbStatePend  = pend_state;
+    os_utilsAddTaskToListByTcb(pTcb, &ReadyTaskList);
+    OS_TRACE(OS_TRACE_EV_READY, pTcb->OS_TcbPrio, pTcb);
+    OS_EXIT_CRITICAL();
 }
 /*
 *********************************************************************************************************
@@ -27,14 +27,30 @@
 #define OS_EVENT_TYPE_UNUSED  0
 #define OS_EVENT_TYPE_SEM     1
 #define OS_EVENT_TYPE_MQ      2
+#define OS_EVENT_TYPE_MUTEX   3
+#define OS_EVENT_TYPE_FLAG    4
+#define OS_EVENT_TYPE_MEM     5
+#define OS_EVENT_TYPE_CQ      6
 
+/* OS_TcbStatePend, why the task is readied from waiting on an event */
 #define OS_STAT_PEND_OK       0
+#define OS_STAT_PEND_TO       1
+
+/* OS_TcbState bits */
 #define OS_STATE_SEM          1
 #define OS_STAT_MQ            2
+#define OS_STAT_DLY           4      /* in DelayedTaskList */
+#define OS_STAT_MUTEX         8
+#define OS_STAT_FLAG          16
+#define OS_STAT_MEM           32
+#define OS_STAT_CQ            64
+#define OS_STAT_PEND_ANY      (OS_STATE_SEM | OS_STAT_MQ | OS_STAT_MUTEX | OS_STAT_FLAG | OS_STAT_MEM | OS_STAT_CQ)
 
 void OS_InitEventList(void);
 void OS_EventWaitListInit(OS_EVENT *pEvent);
 void OS_EventTaskWait(OS_TCB *tcb_curr);
+void OS_EventTaskRemove(OS_TCB *pTcb);
+void OS_EventTaskReadyByTcb(OS_TCB *pTcb, uint8_t msk, uint8_t pend_state);
 uint8_t OS_EventTaskReady(OS_EVENT  *pEvent,
                           void      *pMsg,
                           uint8_t   msk,
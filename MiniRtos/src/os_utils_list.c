@@ -20,18 +20,19 @@
 
 #include "os.h"
 #include "os_utils_list.h"
-#include <stdlib.h>
 #include "qassert.h"
 #include "os_utils_event.h"
 
 Q_DEFINE_THIS_FILE
 
-static Task_List* getTaskList( uint8_t whichList);
+Q_ASSERT_STATIC(MAX_TASK_PRIORITY <= 255); /* OS_TcbPrio is uint8_t */
+
 /*
 *********************************************************************************************************
 *              Initialized all task lists and bitmap
 *
-* Description: Initialized all task lists to 0 (NULL) and TaskRriorityBitMap to 0.
+* Description: Initialized ReadyTaskList to 0 (NULL) and its bit maps to 0, and empty the
+*              delayed task list. The wait list of each event is initialized when the event is created.
 *
 * Arguments  : 
 **
@@ -40,375 +41,347 @@ static Task_List* getTaskList( uint8_t whichList);
 *********************************************************************************************************
 */
 void os_utilsTaskListInit(){
-    uint8_t i;
+    uint16_t i;
     for(i=0;i<MAX_TASKS_IN_LIST;i++){
         ReadyTaskList.TaskList[i] = 0;
-        DelayedTaskList.TaskList[i]= 0;
-        WaitingTaskList.TaskList[i]= 0;
     }
-    ReadyTaskList.TaskRriorityBitMap =0;
-    DelayedTaskList.TaskRriorityBitMap =0;
-    WaitingTaskList.TaskRriorityBitMap =0;    
+    for(i=0;i<PRIORITY_GROUPS;i++){
+        ReadyTaskList.TaskRriorityBitMap[i] =0;
+    }
+    ReadyTaskList.TaskGroupBitMap =0;
+    DelayedTaskList.DelayedTaskHead = 0;
+}
+
+/*
+*********************************************************************************************************
+*              Get the highest priority in a task list
+*
+* Description: This function finds the highest priority which has task(s) in a task list with the two
+*              level bit map. LOG2 of the group bit map gives the highest group, and LOG2 of the bit map
+*              word of the group gives the priority in the group. So it is two CLZ instructions for any
+*              number of priorities.
+*
+* Arguments  : pTaskList        Specified which task list, it must have task(s)
+**
+* Returns    : uint8_t          The highest priority
+* Note(s)    : This utility function is called by other functions in OS,and should not be used by applications.
+*********************************************************************************************************
+*/
+uint8_t os_utilsGetHighestPriority(Task_List *pTaskList){
+    uint8_t group;
+
+    Q_ASSERT(pTaskList->TaskGroupBitMap != 0U);
+    group = (uint8_t)(LOG2(pTaskList->TaskGroupBitMap) - 1U);
+    return (uint8_t)((group << 5) + (LOG2(pTaskList->TaskRriorityBitMap[group]) - 1U));
 }
 
 /*
 *********************************************************************************************************
 *              Add a task to a specified task list
 *
-* Description: This function add a task to a specified task list. The added task is specified by Task List Node.
+* Description: This function add a task to the end of its priority link list in a specified task list.
+*              The links are in the task TCB, so no memory is allocated. The priority link list is
+*              circular, the last task is the one before the first task, so no walk is needed.
+*              A task of OS_EDF_PRIO added to ReadyTaskList is instead inserted by its deadline, after the
+*              tasks with same or earlier deadline, so the first task has the earliest deadline. This walks
+*              the ready EDF tasks.
+*              A task added to ReadyTaskList gets a whole time slice, so a task which blocked in the middle
+*              of its slice does not wake with the rest of it.
 *
-* Arguments  : *pTaskNode       Task List Node to be added
-*               toWhichTaskList Specify which Task List to add
+* Arguments  : *pTcb            Task TCB to be added
+*               toTaskList      Task List to add, ReadyTaskList or the wait list of an event
 **
 * Returns    : 
 * Note(s)    : This utility function is called by other functions in OS,and should not be used by applications.
+*              The idle task (priority 0) is only in ReadyTaskList, and has no bit in the bit maps.
+*              It runs when the bit map is 0.
 *********************************************************************************************************
 */
-void os_utilsAddTaskToListByNode(Task_List_Node* pTaskNode, uint8_t toWhichTaskList ){
+void os_utilsAddTaskToListByTcb(OS_TCB *pTcb, Task_List *toTaskList ){
     uint8_t index;
-    uint32_t bit;
-    Task_List_Node *tempTask;
-    Task_List_Node **taskList;
-    Task_List *pTaskList;
-    OS_TCB *pTcb;
+    OS_TCB *pFirstTask;
+    OS_TCB **taskList;
     OS_CPU_SR  cpu_sr = 0u;
+#if OS_EDF_PRIO != 0
+    OS_TCB *pNextTask;
+#endif
 
-    index = pTaskNode->pTcb->OS_TcbPrio;
-    Q_ASSERT((index>0) && (index <MAX_TASK_PRIORITY));
-
-    pTaskList = getTaskList(toWhichTaskList);
-    Q_ASSERT(pTaskList);
-    taskList = pTaskList->TaskList;
+    index = pTcb->OS_TcbPrio;
+    Q_ASSERT(OS_PRIO_VALID(index));
+    Q_ASSERT(toTaskList);
+    taskList = toTaskList->TaskList;
     
     OS_ENTER_CRITICAL();
-    if(taskList[index] == 0 ) { /* for this piority, it will be the first task */
-        taskList[index] = pTaskNode;
+    if (toTaskList == &ReadyTaskList) {
+        pTcb->OS_TcbTimeQuantaCtr = pTcb->OS_TcbTimeQuanta;
+    }
+    pFirstTask = taskList[index];
+    if(pFirstTask == 0 ) { /* for this piority, it will be the first task */
+        taskList[index] = pTcb;
+        pTcb->OS_TcbNext = pTcb;
+        pTcb->OS_TcbPrev = pTcb;
     }
-    else { /* this priority level already has task(s) */
-        tempTask = taskList[index];
-        while (tempTask->next != 0 ) {     /* To find last one in the list */ 
-            tempTask= tempTask->next;
+#if OS_EDF_PRIO != 0
+    else if ((index == OS_EDF_PRIO) && (toTaskList == &ReadyTaskList)) { /* insert by deadline */
+        pNextTask = pFirstTask;
+        do { /* find the first task with a later deadline, or the first one after a whole round */
+            if (OS_EDF_BEFORE(pTcb->OS_TcbDeadline, pNextTask->OS_TcbDeadline)) {
+                break;
+            }
+            pNextTask = pNextTask->OS_TcbNext;
+        } while (pNextTask != pFirstTask);
+        pTcb->OS_TcbNext = pNextTask;
+        pTcb->OS_TcbPrev = pNextTask->OS_TcbPrev;
+        pNextTask->OS_TcbPrev->OS_TcbNext = pTcb;
+        pNextTask->OS_TcbPrev = pTcb;
+        if (OS_EDF_BEFORE(pTcb->OS_TcbDeadline, pFirstTask->OS_TcbDeadline)) {
+            taskList[index] = pTcb; /* earliest deadline, it is the one to run */
         }
-        tempTask->next = pTaskNode;  /* tempTask is the last one, add new task to the end of the list */
-        pTaskNode->prev = tempTask;
     }
-    bit = PRIORITY_TO_BIT(index);
-    pTaskList->TaskRriorityBitMap |= bit;
-    
+#endif
+    else { /* this priority level already has task(s), add new task before the first one */
+        pTcb->OS_TcbNext = pFirstTask;
+        pTcb->OS_TcbPrev = pFirstTask->OS_TcbPrev;
+        pFirstTask->OS_TcbPrev->OS_TcbNext = pTcb;
+        pFirstTask->OS_TcbPrev = pTcb;
+    }
+    if (index != 0U) {
+        toTaskList->TaskRriorityBitMap[PRIORITY_TO_GROUP(index)] |= PRIORITY_TO_BIT(index);
+        toTaskList->TaskGroupBitMap |= PRIORITY_TO_BIT(PRIORITY_TO_GROUP(index));
+    }
     OS_EXIT_CRITICAL();
 }
 /*
 *********************************************************************************************************
-*              Add a task to ReadyTaskList
+*              Add a task to DelayedTaskList
 *
-* Description: This function add a task to ReadyTaskList. The added task is specified by task tcb.
+* Description: This function add a task to DelayedTaskList. The added task is specified by task tcb.
+*              DelayedTaskList is a delta list ordered by wake up tick. On entry OS_TcbTimeout holds the
+*              ticks to delay. The list is walked to find the insert position, and OS_TcbTimeout of the
+*              added task and of the task after it are changed to be relative to the task before them.
+*              Tasks with same wake up tick are woken up in the order they are added.
 *
-* Arguments  : *task_tcb       task tcb to be added
+* Arguments  : *pTcb            Task TCB to be added
 **
-* Returns    : uint8_t         the added result status
+* Returns    : 
 * Note(s)    : This utility function is called by other functions in OS,and should not be used by applications.
-               The task list node is dynamically allocated. Once allocated, for deep embedded system,it will not
-               be freed till the programe terminated. With limited tasks, it will not cause memeory leak.
+*              DelayedTaskList has its own links in the TCB, so a task waiting on an event can be in the
+*              wait list of the event at the same time.
 *********************************************************************************************************
 */
-uint8_t os_utilsAddTaskToReadyListByTcb(OS_TCB *task_tcb ){
-    uint8_t index;
-    uint32_t bit;
-    Task_List_Node *pTempTask;
-    Task_List_Node *pWalkTask;
+void os_utilsAddTaskToDelayedListByTcb(OS_TCB *pTcb ){
+    uint32_t ticks;
+    OS_TCB *pWalkTask;
+    OS_TCB *pPrevTask;
     OS_CPU_SR  cpu_sr = 0u;
 
-    index = task_tcb->OS_TcbPrio;
-
-    Q_ASSERT(index <= MAX_TASK_PRIORITY );
-    pTempTask = malloc(sizeof(Task_List_Node));
-    if(!pTempTask)
-        return OS_ERR_OTHER;
-    pTempTask->prev = 0;
-    pTempTask->next =0;
-    pTempTask->pTcb = task_tcb;
-
-    bit = PRIORITY_TO_BIT(index);
+    ticks = pTcb->OS_TcbTimeout;
+    Q_ASSERT(ticks != 0U);
+    Q_ASSERT((pTcb->OS_TcbState & OS_STAT_DLY) == 0U);
+    pTcb->OS_TcbDlyPrev = 0;
+    pTcb->OS_TcbDlyNext = 0;
+    
     OS_ENTER_CRITICAL();
-    if(ReadyTaskList.TaskList[index] == 0 ) { /* for this piority, it is first task */
-        ReadyTaskList.TaskList[index] = pTempTask;
-        ReadyTaskList.TaskRriorityBitMap |= bit;
+    pPrevTask = 0;
+    pWalkTask = DelayedTaskList.DelayedTaskHead;
+    while ((pWalkTask != 0) && (pWalkTask->OS_TcbTimeout <= ticks)) {
+        ticks -= pWalkTask->OS_TcbTimeout; /* make it relative to the walked task */
+        pPrevTask = pWalkTask;
+        pWalkTask = pWalkTask->OS_TcbDlyNext;
+    }
+    pTcb->OS_TcbTimeout = ticks;
+    if (pWalkTask != 0) { /* the walked task wakes up later, it is relative to added task now */
+        pWalkTask->OS_TcbTimeout -= ticks;
+        pWalkTask->OS_TcbDlyPrev = pTcb;
+        pTcb->OS_TcbDlyNext = pWalkTask;
+    }
+    if (pPrevTask == 0) { /* it wakes up first */
+        DelayedTaskList.DelayedTaskHead = pTcb;
     }
     else {
-        /* for this piority, it already has task(s), add to end */
-        pWalkTask = ReadyTaskList.TaskList[index];
-        while (pWalkTask->next != 0 ){
-            pWalkTask= pWalkTask->next;
-        }
-        pWalkTask->next = pTempTask;
-        pTempTask->prev = pWalkTask; 
-    }        
+        pPrevTask->OS_TcbDlyNext = pTcb;
+        pTcb->OS_TcbDlyPrev = pPrevTask;
+    }
+    pTcb->OS_TcbState |= OS_STAT_DLY;
     OS_EXIT_CRITICAL();
-    return OS_ERR_NONE;
 }
 /*
 *********************************************************************************************************
-*              Add a task to DelayedTaskList
+*              Remove the first task from DelayedTaskList
 *
-* Description: This function add a task to DelayedTaskList. The added task is specified by task list node.
+* Description: This function removes the first task, which is the task to wake up first, from
+*              DelayedTaskList. The next task becomes the first one. Its OS_TcbTimeout is already the
+*              ticks left, because it is relative to the removed task.
 *
-* Arguments  : *pTaskNode       Task List Node to be added
+* Arguments  : None
 **
-* Returns    : 
+* Returns    : OS_TCB*    The removed task TCB, or 0 if DelayedTaskList is empty
 * Note(s)    : This utility function is called by other functions in OS,and should not be used by applications.
 *********************************************************************************************************
 */
-void os_utilsAddTaskToDelayedListByNode(Task_List_Node *pTaskNode ){
-    uint8_t index;
-    uint32_t bit;
-    Task_List_Node *pWalkTask;
+OS_TCB *os_utilsRemoveFromDelayedListHead(void){
+    OS_TCB *pTcb;
     OS_CPU_SR  cpu_sr = 0u;
 
-    index = pTaskNode->pTcb->OS_TcbPrio;
-    Q_ASSERT((index>0) && (index<=MAX_TASK_PRIORITY));
-    pTaskNode->prev = 0;
-    pTaskNode->next =0;
-    bit = PRIORITY_TO_BIT(index);
-    
     OS_ENTER_CRITICAL();
-    if(DelayedTaskList.TaskList[index] == 0 ) { /* for this piority, it is first task */
-        DelayedTaskList.TaskList[index] = pTaskNode;
-    }
-    else { /* this priority level already has task(s) */
-        pWalkTask = DelayedTaskList.TaskList[index];
-        while (pWalkTask->next != 0 ){
-            pWalkTask= pWalkTask->next;
-        }
-        pWalkTask->next = pTaskNode;
-        pTaskNode->prev = pWalkTask;
-        
+    pTcb = DelayedTaskList.DelayedTaskHead;
+    if (pTcb != 0) {
+        os_utilsRemoveFromDelayedListByTcb(pTcb);
     }
-    DelayedTaskList.TaskRriorityBitMap |= bit;
     OS_EXIT_CRITICAL();
+    return pTcb;
 }
 /*
 *********************************************************************************************************
-*              Remove the task from the specified task list
+*              Remove a task from DelayedTaskList
 *
-* Description: This function remove a task matching by TCB form the specified task list.
+* Description: This function removes a task from DelayedTaskList before its timeout, for example a task
+*              waiting on an event with timeout gets the event. The ticks left of the task are added to
+*              the task after it, so the wake up tick of the task after it is not changed.
 *
-* Arguments  : *task_tcb        Matched task TCB to be removed
-*              fromWhichList    Specified which task list
+* Arguments  : *pTcb            Task TCB to be removed, it must be in DelayedTaskList
 **
-* Returns    : Task_List_Node*    The task list node matched the task TCB
+* Returns    : 
 * Note(s)    : This utility function is called by other functions in OS,and should not be used by applications.
 *********************************************************************************************************
 */
-Task_List_Node *os_utilsRemoveFromListByTaskTcb(OS_TCB *task_tcb, uint8_t fromWhichList ){
-    uint8_t index;
-    uint32_t bit;
-    Task_List_Node *pWalkTask;
-    Task_List_Node **taskList;
-    Task_List *pTaskList;
+void os_utilsRemoveFromDelayedListByTcb(OS_TCB *pTcb){
     OS_CPU_SR  cpu_sr = 0u;
 
-    index = task_tcb->OS_TcbPrio;
-    Q_ASSERT((index>0) && (index<=MAX_TASK_PRIORITY));
-    bit = PRIORITY_TO_BIT(index);
-    
-    pTaskList = getTaskList(fromWhichList);
-    Q_ASSERT(pTaskList);
-    taskList = pTaskList->TaskList;
-        
+    Q_ASSERT((pTcb->OS_TcbState & OS_STAT_DLY) != 0U);
     OS_ENTER_CRITICAL();
-    pWalkTask = taskList[index];
-
-    if( pWalkTask->next == 0 ) { /* this is the only task in list */
-        if( pWalkTask->pTcb == task_tcb ){     
-            taskList[index] =0;
-            pTaskList->TaskRriorityBitMap &= ~bit;
-            OS_EXIT_CRITICAL();
-            return pWalkTask;
-        } else {
-            OS_EXIT_CRITICAL();
-            return (Task_List_Node*)0; /* No match found */
-        }
+    if (pTcb->OS_TcbDlyNext != 0) {
+        pTcb->OS_TcbDlyNext->OS_TcbTimeout += pTcb->OS_TcbTimeout;
+        pTcb->OS_TcbDlyNext->OS_TcbDlyPrev = pTcb->OS_TcbDlyPrev;
     }
-    while ((pWalkTask->pTcb != task_tcb ) && (pWalkTask)){
-        pWalkTask= pWalkTask->next;
+    if (pTcb->OS_TcbDlyPrev == 0) { /* it is the first one */
+        Q_ASSERT(DelayedTaskList.DelayedTaskHead == pTcb);
+        DelayedTaskList.DelayedTaskHead = pTcb->OS_TcbDlyNext;
     }
-
-    if( pWalkTask == 0 ) {
-        OS_EXIT_CRITICAL();
-        return (Task_List_Node*)0; /* No match found */
-    }
-    else { /* remove pWalkTask */
-        if( pWalkTask->next == 0){ /*pWalkTask is the last one */
-            pWalkTask->prev->next = 0;
-        } else if( pWalkTask->prev ==0 ){ /* This is the first one to be removed */
-            pWalkTask->next->prev =0;
-            taskList[index] = pWalkTask->next;
-        }
-        else{ /* This is middle one to be removed */
-            pWalkTask->prev->next = pWalkTask->next;
-            pWalkTask->next->prev =  pWalkTask->prev;
-        }
+    else {
+        pTcb->OS_TcbDlyPrev->OS_TcbDlyNext = pTcb->OS_TcbDlyNext;
     }
+    pTcb->OS_TcbDlyNext = 0;
+    pTcb->OS_TcbDlyPrev = 0;
+    pTcb->OS_TcbState &= ~OS_STAT_DLY;
     OS_EXIT_CRITICAL();
-    pWalkTask->prev = 0;
-    pWalkTask->next = 0;
-    return pWalkTask;
 }
 /*
 *********************************************************************************************************
-*              Remove the task from the Waiting task list
+*              Remove the task from the specified task list
 *
-* Description: This function remove the highiest priority task which is waiting for 
-*              the even from the Waiting task list.
+* Description: This function remove a task form the specified task list. The task is unlinked by the
+*              links in its TCB, no search is needed. If the task is the first one, the task after it
+*              becomes the first one.
 *
-* Arguments  : pEvent             The even the task is waiting for.
+* Arguments  : *task_tcb        Task TCB to be removed, it must be in the task list
+*              fromTaskList     Specified which task list
 **
-* Returns    : Task_List_Node*    The highiest priority task in the waiting task node which waiting for the spceified event
-* Note(s)    : This utility function called by other functions in OS,and should not be used by applications.
-               This function search from highiest priority task, once find a task waiting for the specifyied even
-               it will return withour further searching.
+* Returns    : 
+* Note(s)    : This utility function is called by other functions in OS,and should not be used by applications.
 *********************************************************************************************************
 */
-Task_List_Node *os_utilsRemoveFromWaitingListHPT(OS_EVENT  *pEvent){
+void os_utilsRemoveFromListByTaskTcb(OS_TCB *task_tcb, Task_List *fromTaskList ){
     uint8_t index;
-    uint32_t bit;
-    Task_List_Node **taskList;
-    uint32_t workingSet;
-    Task_List_Node *pTask;
-    OS_TCB *pTcb; 
+    uint8_t group;
+    OS_TCB **taskList;
     OS_CPU_SR  cpu_sr = 0u;
 
-    taskList = WaitingTaskList.TaskList;
-    workingSet = WaitingTaskList.TaskRriorityBitMap;
-    while (workingSet != 0U) {
-        index  = LOG2(workingSet);
-        pTask = taskList[index];
-        pTcb = pTask->pTcb;
-        Q_ASSERT(pTcb!= (OS_TCB *)0);
-        bit = (1U << (pTcb->OS_TcbPrio - 1U));
-
-        while(pTask!= 0)
-        {
-            if (pTask->pTcb->OS_TcbEcbPtr == pEvent)
-            { /* Matched, will return */
-                if((pTask->next == 0)&& (pTask->prev ==0) )
-                { /* only one task in the priority group */
-                    taskList[index] = 0;
-                    bit = (1U << (pTcb->OS_TcbPrio - 1U));
-                    WaitingTaskList.TaskRriorityBitMap &= ~bit;
-                }
-                else { /* this prority group has more than one tasks */
-                    if( pTask->prev == 0 )
-                    { /* first in the list */
-                        taskList[index] = pTask->next;
-                        pTask->next->prev=0;
-                    } else if( pTask->next == 0)
-                    { /*last one */
-                        pTask->prev->next =0;
-                    } else
-                    { /*middle node */
-                        pTask->prev->next = pTask->next;
-                        pTask->next->prev = pTask->prev;
-                    }
-                }
-                pTask->prev = 0;
-                pTask->next = 0;
-                return pTask;
-            } /* no matched found */
-            pTask = pTask->next;
-        } /* while(pTask!= 0) */  
-        workingSet &= ~bit; /* remove from working set */
-    } /* while (workingSet != 0U) */
-    return 0;
+    index = task_tcb->OS_TcbPrio;
+    group = PRIORITY_TO_GROUP(index);
+    Q_ASSERT((index>0) && OS_PRIO_VALID(index));
+    Q_ASSERT(fromTaskList);
+    taskList = fromTaskList->TaskList;
+        
+    OS_ENTER_CRITICAL();
+    Q_ASSERT(taskList[index] != 0);
+    if (task_tcb->OS_TcbNext == task_tcb) { /* this is the only task in list */
+        Q_ASSERT(taskList[index] == task_tcb);
+        taskList[index] = 0;
+        fromTaskList->TaskRriorityBitMap[group] &= ~PRIORITY_TO_BIT(index);
+        if (fromTaskList->TaskRriorityBitMap[group] == 0U) { /* last priority used in the group */
+            fromTaskList->TaskGroupBitMap &= ~PRIORITY_TO_BIT(group);
+        }
+    }
+    else {
+        task_tcb->OS_TcbPrev->OS_TcbNext = task_tcb->OS_TcbNext;
+        task_tcb->OS_TcbNext->OS_TcbPrev = task_tcb->OS_TcbPrev;
+        if (taskList[index] == task_tcb) { /* This is the first one to be removed */
+            taskList[index] = task_tcb->OS_TcbNext;
+        }
+    }
+    OS_EXIT_CRITICAL();
+    task_tcb->OS_TcbPrev = 0;
+    task_tcb->OS_TcbNext = 0;
 }
 /*
 *********************************************************************************************************
-*              Remove the task from the task list
+*              Rotate a priority link list
 *
-* Description: This function remove the task list node from the spcified task list.
+* Description: This function makes the second task of a priority link list the first one, and the first
+*              one becomes the last one. The first task of a priority link list in ReadyTaskList is the
+*              one to run for the priority, so this is the round robin among same priority tasks.
 *
-* Arguments  : taskToBeRemove    The task list node to be removed.
-*              fromWhichList     Specify which list from the task to remove  
+* Arguments  : pTaskList        Specified which task list
+*              prio             Priority of the link list to rotate
 **
-* Returns    : Task_List_Node*    The tassk list node removed.
-* Note(s)    : This function called by other functions in OS,and should not be used by applications.
-               (1)taskToBeRemove must be in theTaskList
-               (2)the function is called with taskToBeRemove's prev and next un-touched. 
-                  Othersie, has to use while loop to search the whole list 
-                  to check if taskToBeRemove is matched in the list
+* Returns    : OS_TCB*          The new first task, may be the old one if it is the only one, or 0 if
+*                               no task in the priority link list
+* Note(s)    : This utility function is called by other functions in OS,and should not be used by applications.
 *********************************************************************************************************
 */
-Task_List_Node *os_utilsRemoveFromListByTaskNode(Task_List_Node *taskToBeRemove, 
-                                  uint8_t fromWhichList){
-    uint8_t index;
-    uint32_t bit;
-    Task_List *taskList;
-    Task_List_Node *pTaskNode;
+OS_TCB *os_utilsRotateTaskList(Task_List *pTaskList, uint8_t prio){
+    OS_TCB *pTcb;
     OS_CPU_SR  cpu_sr = 0u;
-                                      
-    Q_ASSERT(taskToBeRemove);
-    index = taskToBeRemove->pTcb->OS_TcbPrio;
-    Q_ASSERT((index>0) && (index<=MAX_TASK_PRIORITY));
-    bit = PRIORITY_TO_BIT(index);
 
-    taskList = getTaskList(fromWhichList);
-    Q_ASSERT(taskList);                                      
+    Q_ASSERT(OS_PRIO_VALID(prio));
     OS_ENTER_CRITICAL();
-    pTaskNode = taskList->TaskList[index];
-                                      
-    if( pTaskNode->next == 0 ) { /* this is the only task in list */
-        taskList->TaskList[index] =0;
-        taskList->TaskRriorityBitMap &= ~bit;
-    }
-    else { /* The list has more than one tasks */
-        if( taskToBeRemove->prev == 0 ){ /* first one */
-            pTaskNode = taskToBeRemove;
-            taskToBeRemove->next->prev=0;
-            taskList->TaskList[index] = taskToBeRemove->next;
-        }
-        else if ( taskToBeRemove->next == 0 ) /* last one */
-        {
-            pTaskNode = taskToBeRemove;
-            taskToBeRemove->prev->next = 0;
-        }
-        else { /* Middle one */
-            pTaskNode = taskToBeRemove;
-            taskToBeRemove->prev->next = taskToBeRemove->next;
-            taskToBeRemove->next->prev = taskToBeRemove->prev;
-        }
+    pTcb = pTaskList->TaskList[prio];
+    if (pTcb != 0) {
+        pTcb = pTcb->OS_TcbNext;
+        pTaskList->TaskList[prio] = pTcb;
     }
     OS_EXIT_CRITICAL();
-    pTaskNode->next=0;
-    pTaskNode->prev=0;
-    return pTaskNode;
+    return pTcb;
 }
-
 /*
 *********************************************************************************************************
-*              Get address for one of the three task lists
+*              Change the priority of a task
 *
-* Description: This function gets the address for one of ReadyTaskList, DelayedTaskList, and WaitingTaskList
+* Description: This function changes the priority of a task, and re-queues the task in the task list it
+*              is in, so the task is found at its new priority. A task waiting on an event is in the wait
+*              list of the event, a task only delayed by OS_Delay() is in no priority list, and other tasks
+*              are in ReadyTaskList. The task is added as the last one of the new priority.
 *
-* Arguments  : whichList    Specify one of the three list.
+* Arguments  : *pTcb            Task TCB to change
+*              prio             New priority
 **
-* Returns    : Task_List*    Adress of the return task list.
-* Note(s)    : This function called by functions in this file only.
+* Returns    : 
+* Note(s)    : This utility function is called by other functions in OS,and should not be used by applications.
+*              The idle task must not change priority.
 *********************************************************************************************************
 */
-static Task_List* getTaskList( uint8_t whichList){
+void os_utilsChangeTaskPrio(OS_TCB *pTcb, uint8_t prio){
     Task_List *pTaskList;
-    
-    if( whichList == READY_TASK_LIST) {
-        pTaskList = &ReadyTaskList;
-    }
-    else if ( whichList == DELAYED_TASK_LIST) {
-        pTaskList = &DelayedTaskList;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    Q_ASSERT((prio > 0) && OS_PRIO_VALID(prio));
+    OS_ENTER_CRITICAL();
+    if (pTcb->OS_TcbEcbPtr != (OS_EVENT *)0) {       /* waiting on an event */
+        pTaskList = &pTcb->OS_TcbEcbPtr->OS_EventWaitList;
     }
-    else if ( whichList == WAITING_TASK_LIST ) {
-        pTaskList = &WaitingTaskList;
+    else if ((pTcb->OS_TcbState & OS_STAT_DLY) != 0U) { /* delayed only */
+        pTaskList = (Task_List *)0;
     }
     else {
-       pTaskList = 0;
+        pTaskList = &ReadyTaskList;
+    }
+    if (pTaskList != (Task_List *)0) {
+        os_utilsRemoveFromListByTaskTcb(pTcb, pTaskList);
     }
-    return pTaskList;
+    pTcb->OS_TcbPrio = prio;
+    if (pTaskList != (Task_List *)0) {
+        os_utilsAddTaskToListByTcb(pTcb, pTaskList);
+    }
+    OS_EXIT_CRITICAL();
 }
@@ -26,36 +26,34 @@
 #define OS_TASK_PENDING    0
 #define OS_NO_TASK_PENDING 1
 
-#define READY_TASK_LIST    1
-#define DELAYED_TASK_LIST  2
-#define WAITING_TASK_LIST  3
-
-#define MAX_TASK_PRIORITY     8
-#define MAX_TASKS_IN_LIST     MAX_TASK_PRIORITY+1
-
-#define GET_CURRENT_TCB() OS_tcb_curr 
-
-typedef struct task_list_node{
-    struct  task_list_node *prev;
-    struct  task_list_node *next;
-    OS_TCB  *pTcb;
-} Task_List_Node;
-
-typedef struct task_list{
-    Task_List_Node *TaskList[MAX_TASKS_IN_LIST];
-    uint32_t   TaskRriorityBitMap;
-} Task_List;
+#define GET_CURRENT_TCB() OS_tcb_curr
+
+/* a uint8_t priority is always valid with 256 priorities, and the compare would warn (-Wtype-limits) */
+#if MAX_TASK_PRIORITY < 255
+#define OS_PRIO_VALID(prio_)  ((prio_) <= MAX_TASK_PRIORITY)
+#else
+#define OS_PRIO_VALID(prio_)  (1)
+#endif 
+
+/* Delta list of delayed tasks, linked by OS_TcbDlyNext/OS_TcbDlyPrev. The tasks are ordered by wake
+   up tick, and the OS_TcbTimeout of each task holds the ticks to wait after the task before it wakes
+   up. So OS_tick() only decrements the first task, and only touches the tasks which actually expire.
+   It has the tasks called OS_Delay(), and the tasks waiting on an event with timeout. */
+typedef struct delayed_task_list{
+    OS_TCB *DelayedTaskHead;
+} Delayed_Task_List;
 
 extern Task_List ReadyTaskList;
-extern Task_List DelayedTaskList;
-extern Task_List WaitingTaskList;
+extern Delayed_Task_List DelayedTaskList;
 
 void os_utilsTaskListInit();
-void os_utilsAddTaskToListByNode(Task_List_Node* pTaskNode, uint8_t toWhichTaskList );
-uint8_t os_utilsAddTaskToReadyListByTcb(OS_TCB *task_tcb );
-void os_utilsAddTaskToDelayedListByNode(Task_List_Node *pTaskNode );
-Task_List_Node *os_utilsRemoveFromListByTaskTcb(OS_TCB *task_tcb, uint8_t fromWhichList );
-Task_List_Node *os_utilsRemoveFromListByTaskNode(Task_List_Node *taskToBeRemove, uint8_t fromWhichList);
-Task_List_Node *os_utilsRemoveFromWaitingListHPT(OS_EVENT *pEvent);
+uint8_t os_utilsGetHighestPriority(Task_List *pTaskList);
+void os_utilsAddTaskToListByTcb(OS_TCB *pTcb, Task_List *toTaskList );
+void os_utilsAddTaskToDelayedListByTcb(OS_TCB *pTcb );
+void os_utilsRemoveFromListByTaskTcb(OS_TCB *task_tcb, Task_List *fromTaskList );
+OS_TCB *os_utilsRotateTaskList(Task_List *pTaskList, uint8_t prio);
+OS_TCB *os_utilsRemoveFromDelayedListHead(void);
+void os_utilsRemoveFromDelayedListByTcb(OS_TCB *pTcb);
+void os_utilsChangeTaskPrio(OS_TCB *pTcb, uint8_t prio);
 
 #endif /*__OS_UTILS_H__ */
\ No newline at end of file
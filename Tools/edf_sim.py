@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Simulate the utilization periodic tasks can use under EDF and under fixed priority.
+
+    edf_sim.py [--sets 200] [--tasks 5] [--seed 1]
+
+Random sets of periodic tasks, each with its deadline at the release of its next job, are scheduled
+tick by tick like MiniRTOS does it:
+  - fixed priority: rate monotonic, the shorter period the higher priority, ties by task order
+  - EDF: all the tasks at OS_EDF_PRIO, the earliest deadline runs, ties in the order made ready
+A set is schedulable if no job misses its deadline in one hyperperiod from a synchronous release. The
+sets are grouped by their utilization, and each line is CSV, like the benchmarks:
+
+    edf_sim,<utilization>,<sets>,<fixed priority schedulable %>,<EDF schedulable %>
+"""
+
+import argparse
+import random
+from functools import reduce
+from math import gcd
+
+PERIODS = [10, 20, 25, 40, 50, 100, 200]    # ticks, the hyperperiod is 200 ticks
+
+
+def uunifast(n, u, rnd):
+    """n task utilizations which add up to u, uniformly distributed"""
+    utils = []
+    left = u
+    for i in range(1, n):
+        nxt = left * rnd.random() ** (1.0 / (n - i))
+        utils.append(left - nxt)
+        left = nxt
+    utils.append(left)
+    return utils
+
+
+def make_set(n, u, rnd):
+    """(wcet, period) of n tasks, the wcet rounded to whole ticks"""
+    tasks = []
+    for ui in uunifast(n, u, rnd):
+        period = rnd.choice(PERIODS)
+        tasks.append((max(1, round(ui * period)), period))
+    return tasks
+
+
+def schedulable(tasks, edf):
+    hyper = reduce(lambda a, b: a * b // gcd(a, b), (p for _, p in tasks))
+    order = sorted(range(len(tasks)), key=lambda i: (tasks[i][1], i))   # rate monotonic
+    rank = {i: r for r, i in enumerate(order)}
+    ready = []                              # jobs as [deadline, ready order, task, ticks left]
+    seq = 0
+    for t in range(hyper):
+        for i, (wcet, period) in enumerate(tasks):
+            if t % period == 0:
+                ready.append([t + period, seq, i, wcet])
+                seq += 1
+        if not ready:
+            continue
+        if edf:
+            job = min(ready, key=lambda j: (j[0], j[1]))
+        else:
+            job = min(ready, key=lambda j: (rank[j[2]], j[1]))
+        job[3] -= 1
+        if job[3] == 0:
+            ready.remove(job)
+        for j in ready:                     # a job still to run at its deadline missed it
+            if j[0] <= t + 1:
+                return False
+    return not ready
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--sets", type=int, default=200, help="task sets for each utilization")
+    ap.add_argument("--tasks", type=int, default=5, help="tasks in a set")
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    rnd = random.Random(args.seed)
+    print("edf_sim,utilization,sets,fixed_prio_pct,edf_pct")
+    for step in range(10, 21):
+        target = step * 0.05
+        cnt = fp_ok = edf_ok = 0
+        while cnt < args.sets:
+            tasks = make_set(args.tasks, target, rnd)
+            u = sum(float(c) / p for c, p in tasks)
+            if abs(u - target) > 0.025 or u > 1.0:      # the rounding moved it to another group
+                continue
+            cnt += 1
+            fp_ok += schedulable(tasks, False)
+            edf_ok += schedulable(tasks, True)
+        print("edf_sim,%.2f,%u,%u,%u" % (target, cnt, 100 * fp_ok // cnt, 100 * edf_ok // cnt))
+
+
+if __name__ == "__main__":
+    main()
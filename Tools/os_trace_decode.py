@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Decode a MiniRTOS trace dump, written by OS_Trace_Dump(), into a timeline.
+
+    os_trace_decode.py dump.bin [--hz 16000000] [--name 5=blinky --name 2=trace ...]
+
+Each line is the time since the first record, the priority of the running task, the event and its
+arguments. The timestamps are OS_CPU_TS_GET(), the CPU cycles on the target, so --hz is the CPU clock
+to print them in us. Without --hz they are printed as they are, ns on the POSIX port.
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = 0x4352544D
+VERSION = 1
+HDR = struct.Struct("<IBBBBII")
+
+EV_SWITCH, EV_BLOCK, EV_READY, EV_TIMEOUT, EV_POST, EV_ISR_ENTER, EV_ISR_EXIT, EV_USER, EV_STR = range(1, 10)
+
+# OS_STAT_xxx and OS_EVENT_TYPE_xxx of os_utils_event.h
+STATES = [(1, "sem"), (2, "mq"), (4, "dly"), (8, "mutex"), (16, "flag"), (32, "mem"), (64, "cq")]
+EVENT_TYPES = {1: "sem", 2: "mq", 3: "mutex", 4: "flag", 5: "mem", 6: "cq"}
+EXCEPTIONS = {15: "SysTick"}
+
+
+def read_dump(data):
+    magic, version, rec_size, arg1_size, _, cnt, seq = HDR.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a MiniRTOS trace dump")
+    rec = struct.Struct("<IBBH" + ("I" if arg1_size == 4 else "Q"))
+    recs = []
+    off = HDR.size
+    for _ in range(cnt):
+        recs.append(list(rec.unpack_from(data, off)))
+        off += rec_size
+    for r in recs:                      # the strings follow the records, in order
+        if r[1] == EV_STR:
+            (n,) = struct.unpack_from("<H", data, off)
+            r[4] = data[off + 2:off + 2 + n].decode("ascii", "replace")
+            off += 2 + n
+    return seq, recs
+
+
+def describe(ev, arg0, arg1, task):
+    if ev == EV_SWITCH:
+        return "switch    to %s" % task(arg0)
+    if ev == EV_BLOCK:
+        if arg0 == 4:
+            return "block     delay %u ticks" % arg1
+        states = "+".join(name for bit, name in STATES if arg0 & bit) or "0x%x" % arg0
+        return "block     %s 0x%x" % (states, arg1)
+    if ev == EV_READY:
+        return "ready     %s" % task(arg0)
+    if ev == EV_TIMEOUT:
+        return "timeout   %s" % task(arg0)
+    if ev == EV_POST:
+        return "post      %s 0x%x" % (EVENT_TYPES.get(arg0, str(arg0)), arg1)
+    if ev in (EV_ISR_ENTER, EV_ISR_EXIT):
+        name = EXCEPTIONS.get(arg0, "IRQ%u" % (arg0 - 16) if arg0 >= 16 else str(arg0))
+        return "isr %s %s" % ("enter" if ev == EV_ISR_ENTER else "exit ", name)
+    if ev == EV_USER:
+        return "user      %u 0x%x" % (arg0, arg1)
+    if ev == EV_STR:
+        return "str       %s" % arg1
+    return "event %u   %u 0x%x" % (ev, arg0, arg1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("dump")
+    ap.add_argument("--hz", type=float, help="timestamp rate, the CPU clock on the target, to print us")
+    ap.add_argument("--name", action="append", default=[], metavar="PRIO=NAME",
+                    help="name of the task of a priority")
+    args = ap.parse_args()
+
+    names = {0: "idle"}
+    for n in args.name:
+        prio, name = n.split("=", 1)
+        names[int(prio)] = name
+
+    def task(prio):
+        if prio == 0xFF:
+            return "-"
+        return names.get(prio, "prio%u" % prio)
+
+    with open(args.dump, "rb") as f:
+        seq, recs = read_dump(f.read())
+    if seq != 0:
+        print("# %u records before were overwritten" % seq)
+
+    t = 0
+    prev = recs[0][0] if recs else 0
+    for ts, ev, prio, arg0, arg1 in recs:
+        t += (ts - prev) & 0xFFFFFFFF   # 32-bit timestamps wrap around
+        prev = ts
+        when = "%12.3f us" % (t * 1e6 / args.hz) if args.hz else "%12u" % t
+        print("%s  %-8s %s" % (when, task(prio), describe(ev, arg0, arg1, task)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
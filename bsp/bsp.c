@@ -4,9 +4,12 @@
 #include <stdio.h>
 #include "bsp.h"
 #include "os.h"
+#include "os_sched.h"
 #include "qassert.h"
 #include "TM4C123GH6PM.h" /* the TM4C MCU Peripheral Access Layer (TI) */
 
+Q_DEFINE_THIS_FILE
+
 // BASEPRI threshold for "QF-aware" interrupts, see NOTE3
 #define QF_BASEPRI          0x3F
 // CMSIS threshold for "QF-aware" interrupts, see NOTE5
@@ -26,10 +29,15 @@ OS_EVENT *SW1_sema;
 OS_EVENT *SW1_MQ;
 OS_EVENT *TRACE_MQ;
 
+#ifdef MY_PRINTF_ENABLE
+static void uart_txStart(void);
+#endif
+
 #if 1
 uint32_t cnt =0;
 void GPIOPortF_IRQHandler(void) {
     uint8_t msgQueueStstus;
+    OS_TRACE_ISR_ENTER(GPIOF_IRQn + 16);
     if ((GPIOF_AHB->RIS & BTN_SW1) != 0U) { /* interrupt caused by SW1? */
         cnt++;
         if(cnt%2 ==0) {
@@ -47,6 +55,7 @@ void GPIOPortF_IRQHandler(void) {
 #endif 
    }
     GPIOF_AHB->ICR = 0xFFU; /* clear interrupt sources */
+    OS_TRACE_ISR_EXIT(GPIOF_IRQn + 16);
 }
 #endif
 
@@ -94,49 +103,239 @@ void BSP_ledGreenOff(void) {
     GPIOF_AHB->DATA_Bits[LED_GREEN] = 0U;
 }
 
+volatile uint32_t BSP_idleWakes;
+
+#ifdef TICKLESS_IDLE_ENABLE
+static uint32_t cyclesPerTick;  /* SysTick cycles of one OS tick */
+static uint32_t maxIdleTicks;   /* longest sleep the 24-bit SysTick can do */
+#endif
+
 void OS_OnStartup(void) {
     SystemCoreClockUpdate();
     SysTick_Config(SystemCoreClock / BSP_TICKS_PER_SEC);
+#ifdef TICKLESS_IDLE_ENABLE
+    cyclesPerTick = SystemCoreClock / BSP_TICKS_PER_SEC;
+    maxIdleTicks  = SysTick_LOAD_RELOAD_Msk / cyclesPerTick;
+#endif
 
     /* set the SysTick interrupt priority (highest) */
     //NVIC_SetPriority(SysTick_IRQn, 0U);
     /* set the interrupt priorities of "kernel aware" interrupts */
     NVIC_SetPriority(SysTick_IRQn, TASK_AWARE_ISR_PRIO);
     NVIC_SetPriority(GPIOF_IRQn,   TASK_AWARE_ISR_PRIO+1);
+    NVIC_SetPriority(UART0_IRQn,   TASK_AWARE_ISR_PRIO+1);
 
     /* enable IRQs in NVIC... */
     NVIC_EnableIRQ(GPIOF_IRQn);
+#ifdef MY_PRINTF_ENABLE
+    uart_txStart();
+#endif
 }
 
+#ifndef TICKLESS_IDLE_ENABLE
 void OS_OnIdle(void) {
+    BSP_idleWakes++;
     GPIOF_AHB->DATA_Bits[LED_RED] = LED_RED;
     GPIOF_AHB->DATA_Bits[LED_RED] = 0U;
     //OS_Trace("Idle task running");
     __WFI(); /* stop the CPU and Wait for Interrupt */
 }
+#else
+/*
+* Tickless idle. SysTick is reprogrammed to fire at the tick of the next timeout, so the CPU sleeps
+* through all the ticks with nothing to do. After wakeup, the OS ticks are advanced by the ticks slept
+* in one step, and SysTick goes back to one interrupt per tick.
+* PRIMASK is used instead of OS_ENTER_CRITICAL(), because WFI still wakes up on a pending interrupt
+* masked by PRIMASK, but not on one masked by BASEPRI. The few cycles SysTick is stopped while being
+* reprogrammed are lost from OS time.
+*/
+void OS_OnIdle(void) {
+    uint32_t idleTicks;
+    uint32_t ticksLeft;
+    uint32_t cyclesLeft;
+    uint32_t ctrl;
 
-/* support for MY_PRINTF() ====================================================*/
-#ifdef MY_PRINTF_ENABLE
+    BSP_idleWakes++;
+    GPIOF_AHB->DATA_Bits[LED_RED] = LED_RED;
+    GPIOF_AHB->DATA_Bits[LED_RED] = 0U;
 
+    __disable_irq();
+    idleTicks = OS_tickNextTimeout();
+    if (idleTicks > maxIdleTicks) {           /* also when no task is delayed (NO_TIMEOUT) */
+        idleTicks = maxIdleTicks;
+    }
+    if ((idleTicks < 2U) || ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U)) {
+        __WFI();                              /* next tick is needed anyway, normal sleep */
+        __enable_irq();
+        return;
+    }
+
+    /* sleep the rest of current tick plus (idleTicks - 1) ticks */
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    cyclesLeft = SysTick->VAL;
+    if (cyclesLeft == 0U) {                   /* tick boundary just reached, let SysTick handle it */
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        __enable_irq();
+        return;
+    }
+    SysTick->LOAD = cyclesLeft + ((idleTicks - 1U) * cyclesPerTick) - 1U;
+    SysTick->VAL  = 0U;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    __WFI(); /* stop the CPU and Wait for Interrupt */
+
+    ctrl = SysTick->CTRL;                     /* reading CTRL clears COUNTFLAG, read it once */
+    SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+    if ((ctrl & SysTick_CTRL_COUNTFLAG_Msk) != 0U) {
+        /* slept till the timeout. SysTick_Handler() is pending and handles the last tick */
+        idleTicks -= 1U;
+        cyclesLeft = cyclesPerTick;
+    }
+    else {
+        /* woken up earlier by other interrupt, count whole ticks passed */
+        cyclesLeft = SysTick->VAL;
+        ticksLeft  = (cyclesLeft + cyclesPerTick - 1U) / cyclesPerTick;
+        idleTicks -= ticksLeft;
+        cyclesLeft -= (ticksLeft - 1U) * cyclesPerTick;   /* cycles to next tick boundary */
+    }
+    /* next SysTick at the tick boundary, then reload to a normal tick */
+    SysTick->LOAD = cyclesLeft - 1U;
+    SysTick->VAL  = 0U;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = cyclesPerTick - 1U;
+
+    if (idleTicks != 0U) {
+        if (OS_tickAdvance(idleTicks) != 0U) {
+            OS_sched();
+        }
+    }
+    __enable_irq();
+}
+#endif
+
+/* UART0, used by MY_PRINTF() and by the trace dump */
 #define UART_BAUD_RATE      115200U
 #define UART_FR_TXFE        (1U << 7)
 #define UART_FR_RXFE        (1U << 4)
-#define UART_BUSY           (1U << 3)
 #define UART_TXFF           (1U << 5)
 #define UART_TXFIFO_DEPTH   16U
+#define UART_IM_TXIM        (1U << 5)
+
+/* support for MY_PRINTF() ====================================================*/
+#ifdef MY_PRINTF_ENABLE
+
+/*
+* Interrupt driven transmit. The bytes are copied to uartTxBuf, and the UART0 TX interrupt moves them
+* to the TX FIFO. The interrupt is at the transition of the FIFO level through half full, so a write
+* fills the FIFO itself when it is below the level, and the interrupt keeps it filled from then on. A
+* task writing to a full ring waits on uartTxSem, posted by the interrupt when it has made room.
+* Before OS_Run() there is no semaphore and no interrupt yet, so a write busy-waits for the UART.
+*/
+#define UART_TX_BUF_SIZE    256U   /* a power of 2 */
 
+static uint8_t uartTxBuf[UART_TX_BUF_SIZE];
+static uint32_t uartTxHead;        /* bytes put by the tasks, free running */
+static uint32_t uartTxTail;        /* bytes moved to the TX FIFO, free running */
+static uint8_t uartTxWaiting;      /* tasks waiting on uartTxSem for room */
+static OS_EVENT *uartTxSem;
 
+/* moves bytes from the ring to the TX FIFO until the FIFO is full, in a critical section or the ISR */
+static void uart_txFill(void) {
+    while ((uartTxTail != uartTxHead) && ((UART0->FR & UART_TXFF) == 0U)) {
+        UART0->DR = uartTxBuf[uartTxTail & (UART_TX_BUF_SIZE - 1U)];
+        uartTxTail++;
+    }
+}
+
+/* called by OS_OnStartup() when the kernel objects can be created and the interrupts start */
+static void uart_txStart(void) {
+    uartTxSem = OS_Sem_Create(0U, "uartTx");
+    Q_ASSERT(uartTxSem != (OS_EVENT *)0);
+    UART0->ICR = UART_IM_TXIM;
+    UART0->IM |= UART_IM_TXIM;
+    NVIC_EnableIRQ(UART0_IRQn);
+}
+
+void UART0_IRQHandler(void) {
+    OS_TRACE_ISR_ENTER(UART0_IRQn + 16);
+    UART0->ICR = UART_IM_TXIM;     /* clear the TX interrupt */
+    uart_txFill();
+    if ((uartTxHead - uartTxTail) < UART_TX_BUF_SIZE) {
+        for (; uartTxWaiting != 0U; uartTxWaiting--) { /* all of them try again */
+            (void)OS_Sem_Post(uartTxSem);
+        }
+    }
+    OS_TRACE_ISR_EXIT(UART0_IRQn + 16);
+}
+
+/* writes len bytes to UART0. It returns when the bytes are copied to the ring, and waits only when the
+   ring is full. Do not call it from an ISR or the idle task after OS_Run(), as it may block */
+void BSP_uartWrite(void const *pData, uint32_t len) {
+    uint8_t const *p = (uint8_t const *)pData;
+    uint32_t room;
+    uint8_t err;
+    OS_CPU_SR  cpu_sr = 0u;
+
+    while (len != 0U) {
+        OS_ENTER_CRITICAL();
+        room = UART_TX_BUF_SIZE - (uartTxHead - uartTxTail);
+        for (; (room != 0U) && (len != 0U); room--, len--) {
+            uartTxBuf[uartTxHead & (UART_TX_BUF_SIZE - 1U)] = *p++;
+            uartTxHead++;
+        }
+        uart_txFill();             /* start the transmit if the FIFO is below the interrupt level */
+        if ((len != 0U) && (uartTxSem != (OS_EVENT *)0)) {
+            uartTxWaiting++;
+        }
+        OS_EXIT_CRITICAL();
+        if (len != 0U) {
+            if (uartTxSem != (OS_EVENT *)0) {
+                OS_Sem_Wait(uartTxSem, NO_TIMEOUT, &err);
+                Q_ASSERT(err == OS_ERR_NONE);
+            }
+        }
+    }
+}
+
+/*
+* MicroLIB has no block write to retarget, printf() calls fputc() for each byte. The byte is put in the
+* ring in a short critical section, and the FIFO fill, which a write does when the TX interrupt is not
+* running, is left to the '\n'. So the ring buffers the line, and a line takes one fill instead of one
+* for each byte. Only a full ring goes to BSP_uartWrite(), to wait for room.
+*/
 int fputc(int c, FILE *stream) {
+    uint8_t b = (uint8_t)c;
+    OS_CPU_SR  cpu_sr = 0u;
+
     (void)stream; /* unused parameter */
-//    GPIOD_AHB->DATA_Bits[PD1_PIN] = PD1_PIN;
-    /* busy-wait as long as UART busy */
-    while ((UART0->FR & UART_BUSY) != 0) {
+    OS_ENTER_CRITICAL();
+    if ((uartTxHead - uartTxTail) < UART_TX_BUF_SIZE) {
+        uartTxBuf[uartTxHead & (UART_TX_BUF_SIZE - 1U)] = b;
+        uartTxHead++;
+        if (c == '\n') {
+            uart_txFill();
+        }
+        OS_EXIT_CRITICAL();
+    }
+    else {
+        OS_EXIT_CRITICAL();
+        BSP_uartWrite(&b, 1U);
     }
-    UART0->DR = c; /* write the byte into Data Register */
-//    GPIOD_AHB->DATA_Bits[PD1_PIN] = 0;
     return c;
 }
 
+/* moves the ring to the TX FIFO by polling, with the TX interrupt masked, so the bytes after it, written
+   to UART0->DR directly, are not mixed with it */
+static void uart_txDrain(void) {
+    UART0->IM &= ~UART_IM_TXIM;
+    while (uartTxTail != uartTxHead) {
+        while ((UART0->FR & UART_TXFF) != 0U) { /* busy-wait while TX FIFO full */
+        }
+        UART0->DR = uartTxBuf[uartTxTail & (UART_TX_BUF_SIZE - 1U)];
+        uartTxTail++;
+    }
+}
+
 void printf_init() {
     /* enable clock for UART0 and GPIOA (used by UART0 pins) */
     SYSCTL->RCGCUART   |= (1U << 0); /* enable Run mode for UART0 */
@@ -160,23 +359,61 @@ void printf_init() {
     tmp = (((SystemCoreClock * 8U) / UART_BAUD_RATE) + 1U) / 2U;
     UART0->IBRD  = tmp / 64U;
     UART0->FBRD  = tmp % 64U;
-    UART0->LCRH  = (0x3U << 5); /* configure 8-N-1 operation */
+    UART0->LCRH  = (0x3U << 5)  /* configure 8-N-1 operation */
+                    | (1U << 4); /* enable the FIFOs, the TX interrupt is at half full */
     UART0->CTL   = (1U << 0)    /* UART enable */
                     | (1U << 8)  /* UART TX enable */
                     | (1U << 9); /* UART RX enable */
 }
 #endif
 
+#if OS_TRACE_EN != 0
+/* the message is recorded by the trace recorder, a few tens of cycles, and is output by BSP_traceDump() */
+void OS_Trace(char * traceMsg){
+    OS_TRACE(OS_TRACE_EV_STR, 0, traceMsg);
+}
+
+static void bsp_traceWrite(void const *pData, uint32_t len) {
+    uint8_t const *p = (uint8_t const *)pData;
+
+    while (len-- != 0U) {
+        while ((UART0->FR & UART_TXFF) != 0U) { /* busy-wait while TX FIFO full */
+        }
+        UART0->DR = *p++;
+    }
+}
+
+/* writes the trace to UART0 as binary, decode it with Tools/os_trace_decode.py. It busy-waits for the
+   UART, so it is called when the timing does not matter any more, by Q_onAssert() or on demand.
+   The interrupts are disabled, and the text in the TX ring goes out before the dump, not in it */
+void BSP_traceDump(void) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+#ifdef MY_PRINTF_ENABLE
+    uart_txDrain();
+#endif
+    OS_Trace_Dump(&bsp_traceWrite);
+#ifdef MY_PRINTF_ENABLE
+    UART0->IM |= UART_IM_TXIM;     /* the text after an on demand dump, the waiting tasks get room */
+#endif
+    __set_PRIMASK(primask);
+}
+#else
 void OS_Trace(char * traceMsg){
     uint8_t msgQueueStstus;
     
     msgQueueStstus =OS_MsgQ_Send(TRACE_MQ,traceMsg);    
 }
+#endif
 
 //............................................................................
 _Noreturn void Q_onAssert(char const * const module, int const id) {
     (void)module; // unused parameter
     (void)id;     // unused parameter
+#if OS_TRACE_EN != 0
+    BSP_traceDump(); // the events before the assertion
+#endif
 #ifndef NDEBUG
     // light up all LEDs
     GPIOF_AHB->DATA_Bits[LED_GREEN | LED_RED | LED_BLUE] = 0xFFU;
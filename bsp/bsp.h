@@ -7,6 +7,10 @@
 #define MQ_TEST
 #define SEM_TEST
 #define MY_PRINTF_ENABLE
+/* stop SysTick in idle task till the next timeout. The same tickless idle runs on the POSIX port, and
+   `make run` in posix-mini-rtos checks the timeouts fall on the same ticks with and without it. Off
+   until the SysTick reprogramming of OS_OnIdle() in bsp.c is checked on the board */
+//#define TICKLESS_IDLE_ENABLE
 
 void BSP_init(void);
 
@@ -27,7 +31,11 @@ extern OS_EVENT *TRACE_MQ;
 #define MY_PRINTF_INIT()        printf_init()
 
 void printf_init();
+void BSP_uartWrite(void const *pData, uint32_t len);
 void OS_Trace(char * traceMsg);
+void BSP_traceDump(void);
+
+extern volatile uint32_t BSP_idleWakes; /* OS_OnIdle() calls, each one a sleep */
 
 
 #endif // __BSP_H__
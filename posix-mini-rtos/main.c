@@ -0,0 +1,658 @@
+/* MINI RTOS on the POSIX host port. The supervisor first checks the kernel services one by one, each a
+ * PASS or FAIL line: timeouts, mutex priority inheritance, event flags, timers, memory pools, copy
+ * queues, the SPSC ring, the time slice and EDF order. Then the tasks exercise round robin, semaphores and message
+ * queues for a few seconds, and the results are printed and checked. It exits with 0 if all the checks
+ * passed and all the tasks made progress, so it can run in CI.
+ *
+ * The Makefile builds it with more events than the default and with OS_EDF_PRIO set, once with the
+ * periodic tick and once with TICKLESS_IDLE_ENABLE, and runs both. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include "os.h"
+#include "qassert.h"
+
+Q_DEFINE_THIS_FILE
+
+#define TICKS_PER_SEC   1000U
+#define RUN_SECONDS     3U
+
+/* the tick signal frames and the C library run on the task stacks, so they are bigger than on target */
+#define TASK_STK_WORDS  (16U * 1024U)
+
+#define CHECK_PARK_TICKS 0x10000000U /* a check task done delays for ever */
+
+#define MSG_QUEUE_SIZE  8
+void *MsgQueue[MSG_QUEUE_SIZE];
+OS_EVENT *Ping_Sem;
+OS_EVENT *Pong_Sem;
+OS_EVENT *Work_MQ;
+
+/* progress counters, read by the supervisor */
+volatile uint32_t spinCnt[3];
+volatile uint32_t pingPongCnt;
+volatile uint32_t msgCnt;
+#ifdef TICKLESS_IDLE_ENABLE
+volatile uint32_t idleTicksSlept;  /* ticks advanced in one step after a tickless sleep */
+#endif
+
+/* CPU bound tasks of same priority, they share the CPU by time slice */
+uint32_t stack_spin[3][TASK_STK_WORDS];
+OS_TCB spin_tcb[3];
+void main_spin0() { while (1) { spinCnt[0]++; } }
+void main_spin1() { while (1) { spinCnt[1]++; } }
+void main_spin2() { while (1) { spinCnt[2]++; } }
+
+/* two tasks signal each other with two semaphores */
+uint32_t stack_ping[TASK_STK_WORDS];
+OS_TCB ping_tcb;
+void main_ping() {
+    uint8_t err;
+
+    while (1) {
+        (void)OS_Sem_Post(Ping_Sem);
+        OS_Sem_Wait(Pong_Sem, NO_TIMEOUT, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        pingPongCnt++;
+        if ((pingPongCnt % 64U) == 0U) {
+            OS_Delay(1U); /* let the lower priority tasks run */
+        }
+    }
+}
+
+uint32_t stack_pong[TASK_STK_WORDS];
+OS_TCB pong_tcb;
+void main_pong() {
+    uint8_t err;
+
+    while (1) {
+        OS_Sem_Wait(Ping_Sem, NO_TIMEOUT, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        (void)OS_Sem_Post(Pong_Sem);
+    }
+}
+
+/* a producer sends sequence numbers to a consumer, which checks the order */
+uint32_t stack_producer[TASK_STK_WORDS];
+OS_TCB producer_tcb;
+void main_producer() {
+    uintptr_t seq = 0U;
+    uint32_t i;
+
+    while (1) {
+        for (i = 0U; i < 64U; i++) { /* the consumer takes each message at once, or the queue fills */
+            if (OS_MsgQ_Send(Work_MQ, (void *)seq) != OS_ERR_NONE) {
+                break;
+            }
+            seq++;
+        }
+        OS_Delay(1U); /* let the lower priority tasks run */
+    }
+}
+
+uint32_t stack_consumer[TASK_STK_WORDS];
+OS_TCB consumer_tcb;
+void main_consumer() {
+    uint8_t err;
+    uintptr_t seq = 0U;
+    void *msg;
+
+    while (1) {
+        msg = OS_MsgQ_Wait(Work_MQ, NO_TIMEOUT, &err);
+        Q_ASSERT(err == OS_ERR_NONE);
+        Q_ASSERT((uintptr_t)msg == seq);
+        seq++;
+        msgCnt++;
+    }
+}
+
+/* checks of the kernel services ========================================================= */
+/* The supervisor runs each check. The tasks of a check are below it, so they run when it waits, and it
+   sees what they did. Times are checked to the tick, a timeout must expire on the tick it is due */
+#define CHECK_PRIO_HI   9U
+#define CHECK_PRIO_LO   3U
+#define CHECK_TASKS     11U
+
+uint32_t stack_check[CHECK_TASKS][TASK_STK_WORDS];
+OS_TCB check_tcb[CHECK_TASKS];
+uint8_t checkTaskCnt;
+uint32_t checkFails;
+
+OS_EVENT *Check_Sem;                  /* a check task signals the supervisor */
+OS_EVENT *Go_Sem;                     /* the supervisor signals a check task */
+
+void check(char const *name, int ok) {
+    printf("check %-24s %s\n", name, ok ? "PASS" : "FAIL");
+    if (!ok) {
+        checkFails++;
+    }
+}
+
+OS_TCB *check_taskCreate(OS_TCBHandler task, uint8_t prio) {
+    OS_TCB *pTcb;
+
+    Q_REQUIRE(checkTaskCnt < CHECK_TASKS);
+    pTcb = &check_tcb[checkTaskCnt];
+    OS_Task_Create(pTcb, prio, task, stack_check[checkTaskCnt], sizeof(stack_check[checkTaskCnt]));
+    checkTaskCnt++;
+    return pTcb;
+}
+
+void check_park(void) {
+    while (1) {
+        OS_Delay(CHECK_PARK_TICKS);
+    }
+}
+
+/* delays until cond_ holds, at most 100 ticks. The host may run a task late when it is busy, so the
+   checks do not count on a task being done, or waiting, within one tick */
+#define CHECK_UNTIL(cond_) do {                                      \
+    uint32_t n_;                                                     \
+    for (n_ = 0U; !(cond_) && (n_ < 100U); n_++) {                   \
+        OS_Delay(1U);                                                \
+    }                                                                \
+} while (0)
+
+/* a task waits on an event */
+#define CHECK_WAITING(pTcb_)  ((pTcb_)->OS_TcbEcbPtr != (OS_EVENT *)0)
+
+/* wait for a check task to signal, it must within a few ticks */
+int check_waitTask(void) {
+    uint8_t err;
+
+    OS_Sem_Wait(Check_Sem, 100U, &err);
+    return (err == OS_ERR_NONE);
+}
+
+/* OS_Delay(), timeouts of OS_Sem_Wait() and OS_MsgQ_Wait(), and a post before the timeout ------------------- */
+OS_EVENT *Tmo_Sem;
+OS_EVENT *Tmo_MQ;
+void *TmoQueue[2];
+
+void check_tmrPostSem(OS_TMR *pTmr, void *pArg) {
+    (void)pTmr;
+    (void)OS_Sem_Post((OS_EVENT *)pArg);
+}
+
+void check_timeouts(void) {
+    uint32_t t0;
+    uint8_t err;
+    void *msg;
+    OS_TMR *pTmr;
+
+    t0 = OS_TimeGet();
+    OS_Delay(25U);
+    check("delay", (OS_TimeGet() - t0) == 25U);
+
+    t0 = OS_TimeGet();
+    OS_Sem_Wait(Tmo_Sem, 10U, &err);
+    check("sem_timeout", (err == OS_ERR_TIMEOUT) && ((OS_TimeGet() - t0) == 10U));
+
+    t0 = OS_TimeGet();
+    msg = OS_MsgQ_Wait(Tmo_MQ, 5U, &err);
+    check("msgq_timeout", (err == OS_ERR_TIMEOUT) && (msg == (void *)0) && ((OS_TimeGet() - t0) == 5U));
+
+    /* posted by a timer after 3 ticks, before the timeout of 50 ticks */
+    pTmr = OS_Tmr_Create(3U, 0U, OS_TMR_OPT_ONE_SHOT, &check_tmrPostSem, Tmo_Sem, "post", &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+    t0 = OS_TimeGet();
+    (void)OS_Tmr_Start(pTmr);
+    OS_Sem_Wait(Tmo_Sem, 50U, &err);
+    check("sem_post_in_time", (err == OS_ERR_NONE) && ((OS_TimeGet() - t0) == 3U));
+    (void)OS_Tmr_Delete(pTmr);
+
+    /* the task is out of the delayed list, so its old timeout does not wake it again */
+    OS_Sem_Wait(Tmo_Sem, 60U, &err);
+    check("sem_timeout_again", (err == OS_ERR_TIMEOUT) && ((OS_TimeGet() - t0) == 63U));
+}
+
+/* mutex priority inheritance, given back on a waiter timeout and on post -------------------------- */
+OS_EVENT *Check_Mutex;
+#define MUTEX_HI_TMO    20U    /* timeout of the first wait of the high task */
+
+OS_TCB *mutexLoTcb;
+OS_TCB *mutexHiTcb;
+volatile uint32_t mutexHiT0;
+volatile uint8_t mutexHiErr[2];
+volatile uint8_t mutexHiDone;
+
+void main_mutexLo() {
+    uint8_t err;
+
+    OS_Mutex_Wait(Check_Mutex, NO_TIMEOUT, &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+    (void)OS_Sem_Post(Check_Sem);           /* it owns the mutex */
+    OS_Sem_Wait(Go_Sem, NO_TIMEOUT, &err);  /* until the supervisor lets it release it */
+    (void)OS_Mutex_Post(Check_Mutex);
+    check_park();
+}
+
+void main_mutexHi() {
+    uint8_t err;
+
+    mutexHiT0 = OS_TimeGet();
+    OS_Mutex_Wait(Check_Mutex, MUTEX_HI_TMO, &err);
+    mutexHiErr[0] = err;
+    OS_Mutex_Wait(Check_Mutex, NO_TIMEOUT, &err);
+    mutexHiErr[1] = err;
+    mutexHiDone = 1U;
+    (void)OS_Mutex_Post(Check_Mutex);
+    (void)OS_Sem_Post(Check_Sem);
+    check_park();
+}
+
+void check_mutex(void) {
+    uint8_t prioWait;
+    uint8_t prioTimeout;
+
+    mutexLoTcb = check_taskCreate(&main_mutexLo, CHECK_PRIO_LO);
+    Q_ALLEGE(check_waitTask());
+    mutexHiTcb = check_taskCreate(&main_mutexHi, CHECK_PRIO_HI);
+    CHECK_UNTIL(CHECK_WAITING(mutexHiTcb)); /* the high task waits with a timeout */
+    prioWait = mutexLoTcb->OS_TcbPrio;
+    OS_Delay(mutexHiT0 + MUTEX_HI_TMO - OS_TimeGet()); /* wake on its timeout tick, before it runs */
+    prioTimeout = mutexLoTcb->OS_TcbPrio;
+    check("mutex_inherit", prioWait == CHECK_PRIO_HI);
+    check("mutex_timeout_restore", prioTimeout == CHECK_PRIO_LO);
+
+    CHECK_UNTIL(CHECK_WAITING(mutexHiTcb) && (mutexHiErr[0] != 0U)); /* it waits again, for ever */
+    prioWait = mutexLoTcb->OS_TcbPrio;
+    (void)OS_Sem_Post(Go_Sem);
+    Q_ALLEGE(check_waitTask());
+    check("mutex_post_restore", (prioWait == CHECK_PRIO_HI) && (mutexLoTcb->OS_TcbPrio == CHECK_PRIO_LO)
+                                && (mutexHiErr[0] == OS_ERR_TIMEOUT) && (mutexHiErr[1] == OS_ERR_NONE)
+                                && (mutexHiDone != 0U));
+}
+
+/* event flags, wait for all and consume, wait for any, timeout ----------------------------------- */
+OS_EVENT *Check_Flag;
+volatile OS_FLAGS flagsAll;
+volatile OS_FLAGS flagsAny;
+
+void main_flagAll() {
+    uint8_t err;
+
+    flagsAll = OS_Flag_Wait(Check_Flag, 0x0003U, OS_FLAG_WAIT_ALL | OS_FLAG_CONSUME, 0U, &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+    check_park();
+}
+
+void main_flagAny() {
+    uint8_t err;
+
+    flagsAny = OS_Flag_Wait(Check_Flag, 0x000CU, OS_FLAG_WAIT_ANY, 0U, &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+    check_park();
+}
+
+void check_flags(void) {
+    OS_TCB *pAll;
+    OS_TCB *pAny;
+    uint32_t t0;
+    uint8_t err;
+    OS_FLAGS flags;
+    int ok;
+
+    pAll = check_taskCreate(&main_flagAll, CHECK_PRIO_HI);
+    pAny = check_taskCreate(&main_flagAny, CHECK_PRIO_HI);
+    CHECK_UNTIL(CHECK_WAITING(pAll) && CHECK_WAITING(pAny));
+    (void)OS_Flag_Post(Check_Flag, 0x0001U, OS_FLAG_SET);
+    ok = CHECK_WAITING(pAll);               /* one of the two only */
+    (void)OS_Flag_Post(Check_Flag, 0x0002U, OS_FLAG_SET);
+    CHECK_UNTIL(flagsAll != 0U);
+    check("flag_all_consume", ok && (flagsAll == 0x0003U) && (OS_Flag_Query(Check_Flag) == 0U));
+
+    (void)OS_Flag_Post(Check_Flag, 0x0008U, OS_FLAG_SET);
+    CHECK_UNTIL(flagsAny != 0U);
+    check("flag_any", (flagsAny == 0x0008U) && (OS_Flag_Query(Check_Flag) == 0x0008U));
+
+    t0 = OS_TimeGet();
+    flags = OS_Flag_Wait(Check_Flag, 0x0010U, OS_FLAG_WAIT_ALL, 3U, &err);
+    check("flag_timeout", (err == OS_ERR_TIMEOUT) && (flags == 0U) && ((OS_TimeGet() - t0) == 3U));
+}
+
+/* one-shot and periodic timers, on the tick they are due ----------------------------------------- */
+volatile uint32_t tmrCnt[2];
+volatile uint32_t tmrTick[2];
+
+void check_tmrCallback(OS_TMR *pTmr, void *pArg) {
+    uintptr_t i = (uintptr_t)pArg;
+
+    (void)pTmr;
+    tmrCnt[i]++;
+    tmrTick[i] = OS_TimeGet();
+}
+
+void check_timers(void) {
+    uint32_t t0;
+    uint8_t err;
+    OS_TMR *pOneShot;
+    OS_TMR *pPeriodic;
+
+    pOneShot = OS_Tmr_Create(5U, 0U, OS_TMR_OPT_ONE_SHOT, &check_tmrCallback, (void *)0, "one", &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+    pPeriodic = OS_Tmr_Create(3U, 4U, OS_TMR_OPT_PERIODIC, &check_tmrCallback, (void *)1, "per", &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+    t0 = OS_TimeGet();
+    (void)OS_Tmr_Start(pOneShot);
+    (void)OS_Tmr_Start(pPeriodic);
+    OS_Delay(20U);                          /* periodic at 3, 7, 11, 15 and 19 */
+    (void)OS_Tmr_Stop(pPeriodic);
+    check("tmr_one_shot", (tmrCnt[0] == 1U) && (tmrTick[0] == (t0 + 5U)));
+    check("tmr_periodic", (tmrCnt[1] == 5U) && (tmrTick[1] == (t0 + 19U)));
+    OS_Delay(8U);
+    check("tmr_stop", tmrCnt[1] == 5U);
+    (void)OS_Tmr_Delete(pOneShot);
+    (void)OS_Tmr_Delete(pPeriodic);
+}
+
+/* memory pool, a put hands the block to the waiting task ----------------------------------------- */
+uint32_t memPoolSto[2][4];
+OS_MEM *Check_Mem;
+void * volatile memGot;
+
+void main_memPend() {
+    uint8_t err;
+
+    memGot = OS_MemPool_Pend(Check_Mem, 0U, &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+    check_park();
+}
+
+void check_mempool(void) {
+    uint32_t t0;
+    uint8_t err;
+    void *pBlk0;
+    void *pBlk1;
+    OS_MEM_DATA data;
+    OS_TCB *pTcb;
+
+    Check_Mem = OS_MemPool_Create(memPoolSto, 2U, sizeof(memPoolSto[0]), "check", &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+    pBlk0 = OS_MemPool_Get(Check_Mem, &err);
+    pBlk1 = OS_MemPool_Get(Check_Mem, &err);
+    Q_ASSERT((pBlk0 != (void *)0) && (pBlk1 != (void *)0));
+
+    t0 = OS_TimeGet();
+    check("mem_pend_timeout", (OS_MemPool_Pend(Check_Mem, 3U, &err) == (void *)0)
+                              && (err == OS_ERR_TIMEOUT) && ((OS_TimeGet() - t0) == 3U));
+
+    pTcb = check_taskCreate(&main_memPend, CHECK_PRIO_HI);
+    CHECK_UNTIL(CHECK_WAITING(pTcb));       /* it waits, none is free */
+    (void)OS_MemPool_Put(Check_Mem, pBlk1);
+    (void)OS_MemPool_Query(Check_Mem, &data);
+    CHECK_UNTIL(memGot != (void *)0);
+    check("mem_put_handoff", (memGot == pBlk1) && (data.OS_NFree == 0U) && (data.OS_NUsedMax == 2U));
+    check("mem_put_invalid", OS_MemPool_Put(Check_Mem, (uint8_t *)pBlk0 + 1) == OS_ERR_MEM_INVALID);
+}
+
+/* copy queue, the message is copied in at the send ----------------------------------------------- */
+typedef struct check_msg {
+    uint32_t seq;
+    uint32_t data[3];
+} CHECK_MSG;
+
+CHECK_MSG cqSto[2];
+OS_EVENT *Check_CQ;
+volatile CHECK_MSG cqGot;
+
+void main_cqWait() {
+    uint8_t err;
+
+    OS_MsgCQ_Wait(Check_CQ, (void *)&cqGot, 0U, &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+    check_park();
+}
+
+void check_copyQueue(void) {
+    CHECK_MSG msg;
+    CHECK_MSG got;
+    uint8_t err;
+    int ok;
+    OS_TCB *pTcb;
+
+    msg.seq = 1U;
+    msg.data[0] = 0x11111111U;
+    msg.data[1] = 0x22222222U;
+    msg.data[2] = 0x33333333U;
+    ok = (OS_MsgCQ_Send(Check_CQ, &msg) == OS_ERR_NONE);
+    msg.seq = 2U;                           /* the sender may reuse its buffer at once */
+    msg.data[0] = 0U;
+    ok = ok && (OS_MsgCQ_Send(Check_CQ, &msg) == OS_ERR_NONE);
+    ok = ok && (OS_MsgCQ_Send(Check_CQ, &msg) == OS_ERR_Q_FULL);
+    OS_MsgCQ_Wait(Check_CQ, &got, 1U, &err);
+    ok = ok && (err == OS_ERR_NONE) && (got.seq == 1U) && (got.data[0] == 0x11111111U)
+         && (got.data[2] == 0x33333333U);
+    OS_MsgCQ_Wait(Check_CQ, &got, 1U, &err);
+    check("cq_copy", ok && (err == OS_ERR_NONE) && (got.seq == 2U) && (got.data[0] == 0U));
+
+    pTcb = check_taskCreate(&main_cqWait, CHECK_PRIO_HI);
+    CHECK_UNTIL(CHECK_WAITING(pTcb));       /* it waits on the empty queue */
+    msg.seq = 3U;
+    (void)OS_MsgCQ_Send(Check_CQ, &msg);
+    msg.seq = 4U;
+    CHECK_UNTIL(cqGot.seq != 0U);
+    check("cq_handoff", cqGot.seq == 3U);
+}
+
+/* SPSC ring, an interrupt puts and wakes the consumer ------------------------------------------- */
+uint32_t spscSto[4];
+OS_SPSC Check_Spsc;
+volatile uint32_t spscGot;
+
+void check_spscIsr(void) {
+    (void)OS_Spsc_Put(&Check_Spsc, 0x1234U);
+}
+
+void main_spscConsumer() {
+    uint8_t err;
+    uint32_t item;
+
+    OS_Spsc_Pend(&Check_Spsc, &item, 0U, &err);
+    Q_ASSERT(err == OS_ERR_NONE);
+    spscGot = item;
+    check_park();
+}
+
+void check_spsc(void) {
+    uint32_t t0;
+    uint32_t ticks;
+    uint32_t item;
+    uint8_t err;
+    int ok;
+    OS_TCB *pTcb;
+    timer_t hostTmr;
+    struct sigevent sev;
+    struct itimerspec its;
+
+    Q_ALLEGE(OS_Spsc_Create(&Check_Spsc, spscSto, Q_DIM(spscSto), 1U) == OS_ERR_NONE);
+    t0 = OS_TimeGet();
+    OS_Spsc_Pend(&Check_Spsc, &item, 3U, &err);
+    check("spsc_timeout", (err == OS_ERR_TIMEOUT) && ((OS_TimeGet() - t0) == 3U));
+
+    pTcb = check_taskCreate(&main_spscConsumer, CHECK_PRIO_HI);
+    CHECK_UNTIL(CHECK_WAITING(pTcb));       /* it waits on the empty ring */
+    OS_CPU_IntSet(&check_spscIsr);
+    OS_CPU_IntTrigger();
+    CHECK_UNTIL(spscGot != 0U);
+    check("spsc_isr_wake", spscGot == 0x1234U);
+
+    /* the interrupt from a host timer 7.5 ticks later, while the CPU is idle. A tickless sleep ends
+       early, counts the ticks slept, and the ticks go on on the tick boundary. The host may lose ticks
+       when busy, so the ticks to the interrupt are only checked to be before the timeout */
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo  = SIGUSR1;
+    Q_ALLEGE(timer_create(CLOCK_MONOTONIC, &sev, &hostTmr) == 0);
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_nsec = 7500000000L / TICKS_PER_SEC;
+    OS_Delay(1U);                           /* start just after a tick */
+    t0 = OS_TimeGet();
+    Q_ALLEGE(timer_settime(hostTmr, 0, &its, (struct itimerspec *)0) == 0);
+    OS_Spsc_Pend(&Check_Spsc, &item, 50U, &err);
+    ticks = OS_TimeGet() - t0;
+    ok = (err == OS_ERR_NONE) && (item == 0x1234U) && (ticks != 0U) && (ticks < 50U);
+    t0 = OS_TimeGet();
+    OS_Delay(5U);
+    check("spsc_idle_wake", ok && ((OS_TimeGet() - t0) == 5U));
+    (void)timer_delete(hostTmr);
+}
+
+/* time slice, a task readied again gets a whole one ------------------------------------------- */
+void main_slice() {
+    uint32_t t0;
+    uint8_t err;
+
+    t0 = OS_TimeGet();
+    while ((OS_TimeGet() - t0) < 3U) { /* use 3 ticks of the time slice */
+    }
+    OS_Sem_Wait(Go_Sem, NO_TIMEOUT, &err);
+    check_park();
+}
+
+void check_slice(void) {
+    OS_TCB *pTcb;
+    uint32_t left;
+
+    pTcb = check_taskCreate(&main_slice, 8U);
+    CHECK_UNTIL(CHECK_WAITING(pTcb));
+    left = pTcb->OS_TcbTimeQuantaCtr;
+    (void)OS_Sem_Post(Go_Sem);              /* ready, it runs when the supervisor waits */
+    check("slice_reset", (left < pTcb->OS_TcbTimeQuanta)
+                         && (pTcb->OS_TcbTimeQuantaCtr == pTcb->OS_TcbTimeQuanta));
+}
+
+/* EDF, the ready tasks of OS_EDF_PRIO run by deadline ------------------------------------------- */
+#if OS_EDF_PRIO != 0
+uint8_t edfOrder[3];
+uint8_t edfCnt;
+
+void check_edfRun(uint8_t id) {
+    edfOrder[edfCnt++] = id;
+    check_park();
+}
+void main_edf0() { check_edfRun(0U); }
+void main_edf1() { check_edfRun(1U); }
+void main_edf2() { check_edfRun(2U); }
+
+void check_edf(void) {
+    uint32_t now;
+
+    now = OS_TimeGet();
+    OS_Task_SetDeadline(check_taskCreate(&main_edf0, OS_EDF_PRIO), now + 30U);
+    OS_Task_SetDeadline(check_taskCreate(&main_edf1, OS_EDF_PRIO), now + 10U);
+    OS_Task_SetDeadline(check_taskCreate(&main_edf2, OS_EDF_PRIO), now + 20U);
+    CHECK_UNTIL(edfCnt == 3U);              /* they run, earliest deadline first */
+    check("edf_order", (edfCnt == 3U) && (edfOrder[0] == 1U) && (edfOrder[1] == 2U)
+                       && (edfOrder[2] == 0U));
+}
+#endif
+
+/* the highest priority task runs the checks, then the demo tasks, and stops after RUN_SECONDS */
+uint32_t stack_supervisor[TASK_STK_WORDS];
+OS_TCB supervisor_tcb;
+void main_supervisor() {
+    uint32_t start;
+    uint32_t ticks;
+    OS_TCB *pTcb;
+    OS_STK_DATA stk;
+
+    check_timeouts();
+    check_mutex();
+    check_flags();
+    check_timers();
+    check_mempool();
+    check_copyQueue();
+    check_spsc();
+    check_slice();
+#if OS_EDF_PRIO != 0
+    check_edf();
+#endif
+#ifdef TICKLESS_IDLE_ENABLE
+    check("tickless_sleep", idleTicksSlept != 0U); /* the checks above were mostly idle */
+#endif
+
+    OS_Task_Create(&spin_tcb[0], 2U, &main_spin0, stack_spin[0], sizeof(stack_spin[0]));
+    OS_Task_Create(&spin_tcb[1], 2U, &main_spin1, stack_spin[1], sizeof(stack_spin[1]));
+    OS_Task_Create(&spin_tcb[2], 2U, &main_spin2, stack_spin[2], sizeof(stack_spin[2]));
+    OS_Task_Create(&ping_tcb, 5U, &main_ping, stack_ping, sizeof(stack_ping));
+    OS_Task_Create(&pong_tcb, 6U, &main_pong, stack_pong, sizeof(stack_pong));
+    OS_Task_Create(&producer_tcb, 3U, &main_producer, stack_producer, sizeof(stack_producer));
+    OS_Task_Create(&consumer_tcb, 4U, &main_consumer, stack_consumer, sizeof(stack_consumer));
+
+    start = OS_TimeGet();
+    OS_Delay(RUN_SECONDS * TICKS_PER_SEC);
+    ticks = OS_TimeGet() - start;
+
+    printf("ticks        %u\n", (unsigned)ticks);
+    printf("spin         %u %u %u\n", (unsigned)spinCnt[0], (unsigned)spinCnt[1], (unsigned)spinCnt[2]);
+    printf("ping-pong    %u\n", (unsigned)pingPongCnt);
+    printf("messages     %u\n", (unsigned)msgCnt);
+    for (pTcb = OS_Task_GetNext((OS_TCB *)0); pTcb != (OS_TCB *)0; pTcb = OS_Task_GetNext(pTcb)) {
+        (void)OS_Task_StkChk(pTcb, &stk);
+        printf("stack prio %-3u %u of %u bytes used\n", (unsigned)pTcb->OS_TcbBasePrio,
+               (unsigned)stk.OS_StkUsed, (unsigned)stk.OS_StkSize);
+    }
+    if ((checkFails != 0U) || (ticks < (RUN_SECONDS * TICKS_PER_SEC)) || (spinCnt[0] == 0U) || (spinCnt[1] == 0U)
+        || (spinCnt[2] == 0U) || (pingPongCnt == 0U) || (msgCnt == 0U)) {
+        printf("FAIL\n");
+        exit(1);
+    }
+    printf("PASS\n");
+    exit(0);
+}
+
+uint32_t stack_idleThread[TASK_STK_WORDS];
+
+void OS_OnStartup(void) {
+    OS_CPU_TickStart(TICKS_PER_SEC);
+}
+
+/* built with TICKLESS_IDLE_ENABLE, the idle task sleeps till the next timeout, and the checks must give
+   the same results both ways */
+void OS_OnIdle(void) {
+#ifdef TICKLESS_IDLE_ENABLE
+    idleTicksSlept += OS_CPU_IdleTickless(); /* sleep until the next timeout */
+#else
+    OS_CPU_Idle(); /* sleep until the next tick */
+#endif
+}
+
+_Noreturn void Q_onAssert(char const * const module, int const id) {
+    fprintf(stderr, "assertion failed %s:%d\n", module, id);
+    abort();
+}
+
+int main() {
+    OS_Init(stack_idleThread, sizeof(stack_idleThread));
+
+    Ping_Sem = OS_Sem_Create(0, "Ping_Sem");
+    Q_ASSERT(Ping_Sem != (OS_EVENT *)0);
+    Pong_Sem = OS_Sem_Create(0, "Pong_Sem");
+    Q_ASSERT(Pong_Sem != (OS_EVENT *)0);
+    Work_MQ = OS_MsgQ_Create(&MsgQueue[0], MSG_QUEUE_SIZE);
+    Q_ASSERT(Work_MQ != (OS_EVENT *)0);
+
+    Check_Sem = OS_Sem_Create(0, "Check_Sem");
+    Go_Sem = OS_Sem_Create(0, "Go_Sem");
+    Tmo_Sem = OS_Sem_Create(0, "Tmo_Sem");
+    Tmo_MQ = OS_MsgQ_Create(&TmoQueue[0], Q_DIM(TmoQueue));
+    Check_Mutex = OS_Mutex_Create("Check_Mutex");
+    Check_Flag = OS_Flag_Create(0U, "Check_Flag");
+    Check_CQ = OS_MsgCQ_Create(&cqSto[0], Q_DIM(cqSto), sizeof(CHECK_MSG));
+    Q_ASSERT((Check_Sem != (OS_EVENT *)0) && (Go_Sem != (OS_EVENT *)0) && (Tmo_Sem != (OS_EVENT *)0)
+             && (Tmo_MQ != (OS_EVENT *)0) && (Check_Mutex != (OS_EVENT *)0)
+             && (Check_Flag != (OS_EVENT *)0) && (Check_CQ != (OS_EVENT *)0));
+
+    /* the supervisor runs first, it creates the other tasks after the checks */
+    OS_Task_Create(&supervisor_tcb, 10U, &main_supervisor, stack_supervisor, sizeof(stack_supervisor));
+
+    /* transfer control to the RTOS to run the task */
+    OS_Run();
+    Q_ERROR(); /* Should never reach here */
+    return 0;
+}